@@ -0,0 +1,143 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Arduino.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Arduino.h"
+#include "avr/wdt.h"
+#include "avr/eeprom.h"
+#include "util/crc16.h"
+
+//**************************************************************/
+// FIELD DEFINITIONS
+//**************************************************************/
+
+uint8_t SREG = 0;
+uint8_t MCUSR = 0;
+
+HardwareSerial Serial(0), Serial1(1), Serial2(2), Serial3(3);
+
+namespace Host {
+	uint32_t timeUs = 0;
+	uint32_t resetUs = 0;
+	Hardware inert;
+	Hardware* hardware = &inert;
+	uint8_t eeprom[4096];
+}
+
+//**************************************************************/
+// CORE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Returns simulated time since the last reset (us).
+unsigned long micros() {
+	return Host::timeUs - Host::resetUs;
+}
+
+//!b Returns simulated time since the last reset (ms).
+unsigned long millis() {
+	return (Host::timeUs - Host::resetUs) / 1000;
+}
+
+//!b Advances the simulated clock.
+void delay(unsigned long ms) {
+	Host::advance(ms * 1000);
+}
+
+//!b Pin modes have no effect on the host.
+void pinMode(uint8_t, uint8_t) {}
+
+//!b Digital writes have no effect on the host.
+void digitalWrite(uint8_t, uint8_t) {}
+
+//!b Returns the hardware model's analog reading (ADC).
+int analogRead(uint8_t pin) {
+	return Host::hardware->analogRead(pin);
+}
+
+//!b Interrupts never fire on the host.
+void attachInterrupt(uint8_t, void (*)(), int) {}
+
+//!b Advances the simulated clock.
+//!i Time step (us)
+void Host::advance(uint32_t us) {
+	timeUs += us;
+}
+
+//**************************************************************/
+// SERIAL PORT DEFINITIONS
+//**************************************************************/
+
+//!b Constructs port with a number (0 for Serial).
+HardwareSerial::HardwareSerial(uint8_t id) : id(id) {}
+
+//!b Baud rates have no effect on the host.
+void HardwareSerial::begin(unsigned long) {}
+
+//!b Returns number of bytes received.
+int HardwareSerial::available() {
+	return rx.size();
+}
+
+//!b Returns next byte received (-1 if none).
+int HardwareSerial::read() {
+	if(rx.empty()) return -1;
+	uint8_t b = rx.front();
+	rx.pop_front();
+	return b;
+}
+
+//!b Passes a byte to the hardware model.
+size_t HardwareSerial::write(uint8_t b) {
+	Host::hardware->serialWrite(id, b);
+	return 1;
+}
+
+//!b Writes are never buffered on the host.
+void HardwareSerial::flush() {}
+
+//!b Receives a byte from the host tool.
+void HardwareSerial::push(uint8_t b) {
+	rx.push_back(b);
+}
+
+//**************************************************************/
+// AVR LIBRARY DEFINITIONS
+//**************************************************************/
+
+//!b Starts the watchdog (never fires on the host).
+void wdt_enable(uint8_t) {}
+
+//!b Stops the watchdog.
+void wdt_disable() {}
+
+//!b Passes the watchdog reset to the hardware model.
+void wdt_reset() {
+	Host::hardware->watchdogReset();
+}
+
+//!b Reads a block of the simulated EEPROM.
+void eeprom_read_block(void* dst, const void* src, size_t n) {
+	memcpy(dst, Host::eeprom + (size_t)src, n);
+}
+
+//!b Writes a byte of the simulated EEPROM.
+void eeprom_write_byte(uint8_t* p, uint8_t b) {
+	Host::eeprom[(size_t)p] = b;
+}
+
+//!b The simulated EEPROM is always ready.
+int eeprom_is_ready() {
+	return 1;
+}
+
+//!b Updates a CRC-16 (polynomial 0xA001) with a byte.
+uint16_t _crc16_update(uint16_t crc, uint8_t a) {
+	crc ^= a;
+	for(uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+	}
+	return crc;
+}
@@ -0,0 +1,138 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Arduino.h
+//!b Host shim of the Arduino core for the host tools.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This header stands in for the Arduino core so that Namespaces
+//!d code can be compiled and run on a PC. Time comes from a
+//!d simulated clock which the host tool advances itself, so runs
+//!d are deterministic and far faster than real time. The robot
+//!d reads it from its last reset, as the real micros() does.
+//!d Interrupt control is a no-op, as host tools are single
+//!d threaded. Like the real core, min and max are macros, so host
+//!d tools include standard C++ headers before this one.
+//!d
+//!d Everything the robot would read from or write to hardware
+//!d (pins, serial ports, and the libraries in Host/Libraries) is
+//!d passed to Host::hardware. The default Hardware is inert: it
+//!d reads zeros and drops writes. A tool subclasses it to model
+//!d the robot and field.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define F_CPU 16000000UL
+#define RAMEND 0x21FF
+
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+#define CHANGE 1
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+
+// Reset Flags (MCUSR)
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define _BV(bit) (1 << (bit))
+
+#define constrain(amt, low, high) \
+	((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define sq(x) ((x) * (x))
+
+//**************************************************************/
+// CORE FUNCTIONS
+//**************************************************************/
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long);
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int analogRead(uint8_t);
+void attachInterrupt(uint8_t, void (*)(), int);
+
+// Interrupt Control
+extern uint8_t SREG;
+extern uint8_t MCUSR;
+inline void cli() {}
+inline void sei() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+//**************************************************************/
+// SERIAL PORTS
+//**************************************************************/
+
+//!b Serial port with a receive queue filled by the host tool.
+class HardwareSerial {
+public:
+	HardwareSerial(uint8_t);
+	void begin(unsigned long);
+	int available();
+	int read();
+	size_t write(uint8_t);
+	void flush();
+	void push(uint8_t);
+private:
+	uint8_t id;
+	std::deque<uint8_t> rx;
+};
+
+extern HardwareSerial Serial, Serial1, Serial2, Serial3;
+
+//**************************************************************/
+// HOST CONTROLS
+//**************************************************************/
+
+namespace Host {
+
+	//!b Hardware model behind the shims (inert by default).
+	class Hardware {
+	public:
+		virtual ~Hardware() {}
+		virtual int analogRead(uint8_t) { return 0; }
+		virtual void serialWrite(uint8_t, uint8_t) {}
+		virtual void motorVoltage(uint8_t, float) {}
+		virtual float encoderAngle(uint8_t) { return 0; }
+		virtual float imuHeading() { return 0; }
+		virtual float sonar(uint8_t) { return 0; }
+		virtual void servoAngle(uint8_t, float) {}
+		virtual void fanSpeed(float) {}
+		virtual void watchdogReset() {}
+	};
+
+	extern uint32_t timeUs;		// Simulated clock (us)
+	extern uint32_t resetUs;	// Clock at last reset (us)
+	extern Hardware* hardware;
+	extern uint8_t eeprom[4096];	// Simulated EEPROM
+
+	void advance(uint32_t);
+}
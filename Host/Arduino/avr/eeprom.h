@@ -0,0 +1,15 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t eeprom.h
+//!b Host shim of the AVR EEPROM (4 KB, in RAM).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+void eeprom_read_block(void*, const void*, size_t);
+void eeprom_write_byte(uint8_t*, uint8_t);
+int eeprom_is_ready();
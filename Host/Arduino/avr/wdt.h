@@ -0,0 +1,18 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t wdt.h
+//!b Host shim of the AVR watchdog (see Arduino.h).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include <stdint.h>
+
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+
+void wdt_enable(uint8_t);
+void wdt_disable();
+void wdt_reset();
@@ -0,0 +1,12 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t crc16.h
+//!b Host shim of the AVR CRC-16 update.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include <stdint.h>
+
+uint16_t _crc16_update(uint16_t, uint8_t);
@@ -0,0 +1,181 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FireBotReplay.cpp
+//!b Replays a raw input capture through the FireBot code.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Host stand-in for ReplayCapture.m and the robot together. It
+//!d builds the MainBoard code with CAPTURE_ENABLED and
+//!d CAPTURE_REPLAY set to 1, splits a capture into loops as
+//!d ReplayCapture.m does, and answers the robot's requests on the
+//!d capture port with them. Once the capture is exhausted or the
+//!d robot reports divergence, it prints how many loops replayed,
+//!d the final FireBot state, and a digest of the motor and fan
+//!d commands, which match those FireBotSimCapture printed for the
+//!d same run if replay is deterministic.
+//!d
+//!d Captures from the robot replay the same way, but EEPROM is not
+//!d captured, so a field run that resumed from a checkpoint
+//!d diverges at setup.
+
+#include <vector>
+#include <stdio.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Capture.h"
+#include "FireBot.h"
+
+//**************************************************************/
+// CONSTANTS
+//**************************************************************/
+
+const uint8_t SYNC[2] = {0xA5, 0x5A};
+const uint16_t CHUNK_MAX = 256;			// As Capture (bytes)
+const uint8_t PORT_CAPTURE = 2;			// Serial2
+
+// Payload sizes by record type (bytes)
+const uint8_t PAYLOAD[10] = {0, 8, 4, 8, 5, 3, 1, 1, 4, 6};
+
+//**************************************************************/
+// CAPTURE LOOPS
+//**************************************************************/
+
+typedef std::vector<uint8_t> Chunk;
+
+//!b Splits a capture into per-loop chunks of records.
+//!i Capture bytes
+//!i Loop chunks (output)
+//!d Bytes before the first sync are skipped, and a record cut
+//!d off at the end is dropped. Returns false on a bad record type
+//!d or an oversized loop.
+bool split(const Chunk& raw, std::vector<Chunk>& loops) {
+	size_t p = 0;
+	size_t start = 0;
+	bool synced = false;
+	while(p < raw.size()) {
+		if(p + 2 < raw.size() && raw[p] == SYNC[0] &&
+			raw[p + 1] == SYNC[1] && raw[p + 2] == Capture::RECORD_LOOP)
+		{
+			if(synced) loops.push_back(Chunk(&raw[start], &raw[p]));
+			p += 2;
+			start = p;
+			synced = true;
+		} else if(!synced) {
+			p++;
+			continue;
+		}
+		uint8_t type = raw[p];
+		if(type < 1 || type > 9) {
+			fprintf(stderr, "Bad record type 0x%02X at byte %zu\n",
+				type, p);
+			return false;
+		}
+		if(p + 1 + PAYLOAD[type] > raw.size()) break;
+		p += 1 + PAYLOAD[type];
+	}
+	if(synced) loops.push_back(Chunk(&raw[start], &raw[p]));
+	for(const Chunk& c : loops) {
+		if(c.size() > CHUNK_MAX) {
+			fprintf(stderr, "Capture has loops over %u bytes\n",
+				CHUNK_MAX);
+			return false;
+		}
+	}
+	return true;
+}
+
+//**************************************************************/
+// REPLAY HOST
+//**************************************************************/
+
+//!b Replay host on the capture port.
+class Replay : public Host::Hardware {
+public:
+	std::vector<Chunk> loops;
+	uint32_t sent = 0;			// Loops sent
+	bool diverged = false;
+	bool ended = false;			// Sent the end of capture
+	uint32_t outputs = 2166136261u;	// Command digest (FNV-1a)
+
+	void serialWrite(uint8_t, uint8_t) override;
+	void motorVoltage(uint8_t pin, float v) override { digest(pin, v); }
+	void fanSpeed(float s) override { digest(0, s); }
+	void watchdogReset() override;
+private:
+	void digest(uint8_t, float);
+} replay;
+
+clock_t startClock;
+
+//!b Answers a request from the robot with the next loop.
+//!d A divergence report or the end of the capture is answered
+//!d with a length of 0, which idles the robot.
+void Replay::serialWrite(uint8_t port, uint8_t b) {
+	if(port != PORT_CAPTURE) return;
+	if(b == Capture::REPLAY_DIVERGED) diverged = true;
+	if(diverged || sent == loops.size()) {
+		Serial2.push(0);
+		Serial2.push(0);
+		ended = true;
+		return;
+	}
+	const Chunk& c = loops[sent++];
+	Serial2.push(c.size() & 0xFF);
+	Serial2.push(c.size() >> 8);
+	for(uint8_t byte : c) Serial2.push(byte);
+}
+
+//!b Reports the replay once the robot idles.
+void Replay::watchdogReset() {
+	if(!ended) return;
+	double seconds = (double)(clock() - startClock) / CLOCKS_PER_SEC;
+	if(diverged) {
+		printf("Diverged in loop %u of %zu\n", sent - 1, loops.size());
+	} else {
+		printf("Replayed %u loops in %.2f s\n", sent, seconds);
+	}
+	printf("Final state %u, outputs %08X\n", FireBot::getState(),
+		outputs);
+	exit(diverged ? 1 : 0);
+}
+
+//!b Adds a motor or fan command to the output digest.
+//!i Motor pin (0 for the fan)
+//!i Command
+void Replay::digest(uint8_t pin, float v) {
+	uint8_t bytes[5] = {pin};
+	memcpy(bytes + 1, &v, sizeof(v));
+	for(uint8_t i = 0; i < 5; i++) {
+		outputs = (outputs ^ bytes[i]) * 16777619u;
+	}
+}
+
+//**************************************************************/
+// MAIN
+//**************************************************************/
+
+//!b Replays a capture file until it is exhausted or diverges.
+int main(int argc, char** argv) {
+	if(argc != 2) {
+		fprintf(stderr, "Usage: %s capture.bin\n", argv[0]);
+		return 1;
+	}
+	FILE* file = fopen(argv[1], "rb");
+	if(!file) {
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		return 1;
+	}
+	Chunk raw;
+	int c;
+	while((c = fgetc(file)) != EOF) raw.push_back(c);
+	fclose(file);
+	if(!split(raw, replay.loops)) return 1;
+	printf("%zu loops in capture\n", replay.loops.size());
+
+	Host::hardware = &replay;
+	startClock = clock();
+	FireBot::setup();
+	while(true) FireBot::loop();
+}
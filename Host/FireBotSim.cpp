@@ -0,0 +1,1061 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FireBotSim.cpp
+//!b Monte Carlo runs of the FireBot mission on random fields.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Runs the unmodified MainBoard code (FireBot::setup and loop,
+//!d as MainBoard.ino does) against a model of the robot and a
+//!d randomly generated field, and writes one row per run in the
+//!d MissionLog.csv format of RobotConsole, so MissionReport.m can
+//!d summarize simulated and real runs alike.
+//!d
+//!d Fields are a rectangular arena of 2.2 to 2.8 m sides with the
+//!d robot starting at the origin facing +y along the left wall.
+//!d Each has 1 to 3 rectangular islands and up to 2 peninsulas
+//!d from the outer walls, all at least a corridor width apart,
+//!d and a candle at least 0.3 m from any wall and 0.8 m from the
+//!d start. The floor has no cliffs.
+//!d
+//!d The robot model has first-order wheels matching GainTuner.m
+//!d with a few percent of gain mismatch, and slides along walls
+//!d and the candle when it hits them (counted as collisions). The
+//!d IMU heading has a drifting bias and noise, in 1/16 degree
+//!d steps. Sonar rays are cast in a cone and lose the echo off
+//!d steep walls, with noise and dropouts. The
+//!d flame sensor sees a flickering candle through a lobe around
+//!d where the pan-tilt points, if nothing blocks it, and the fan
+//!d puts the candle out after blowing on it for a while. A
+//!d Matlab stand-in connects and polls for data as RobotConsole
+//!d does. Loops take 4 to 6 ms.
+//!d
+//!d Runs end at home, on a fault, or at the time limit. Each run
+//!d is a forked copy of the untouched process, so firmware state
+//!d starts fresh, and runs are seeded by number so any run can be
+//!d repeated alone (with -p to log its pose every loop).
+//!d
+//!d With -r, the robot is reset partway through each run, as by
+//!d the watchdog. A copy of the run forked before the firmware
+//!d started takes over with fresh firmware state, keeping only the
+//!d .noinit RAM, the EEPROM, and the world, and the row logs the
+//!d time from the reset until the robot drives again.
+//!d
+//!d Built as FireBotSimCapture (with CAPTURE_ENABLED), -c saves
+//!d the capture port stream of the first run, which FireBotReplay
+//!d plays back through the replay build. The run's loop count,
+//!d final state, and a digest of its motor and fan commands are
+//!d printed so the replay can be checked against them.
+
+#include <random>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/wait.h>
+#include "Arduino.h"
+#include "Capture.h"
+#include "Checkpoint.h"
+#include "FireBot.h"
+#include "Mission.h"
+#include "Odometer.h"
+#include "WallFollower.h"
+#include "RobotDims.h"
+
+//**************************************************************/
+// CONSTANTS
+//**************************************************************/
+
+// Field Generation
+const double ARENA_MIN = 2.2;		// Side length (m)
+const double ARENA_MAX = 2.8;		// Side length (m)
+const double CORRIDOR = 0.55;		// Min gap between walls (m)
+const double START_CLEAR = 0.45;	// Obstacles from start (m)
+const double CANDLE_WALL_MIN = 0.3;	// (m)
+const double CANDLE_START_MIN = 0.8;	// (m)
+const double CANDLE_RADIUS = 0.06;	// (m)
+
+// Robot Model
+const double ROBOT_RADIUS = 0.13;	// Collision circle at VTC (m)
+const double TRACK = 0.23;			// Wheel track (m)
+const double WHEEL_TAU = 0.08;		// (s)
+const double WHEEL_KV = 20.0;		// (V*s/m)
+const double WHEEL_KS = 1.0;		// (V)
+const double WHEEL_MISMATCH = 0.03;	// Gain spread
+const uint32_t STEP = 1000;			// Integration step (us)
+const double IMU_DRIFT = 0.001;		// Bias walk (rad/sqrt(s))
+const double IMU_NOISE = 0.001;		// (rad)
+const double IMU_LSB = PI / 2880;	// 1/16 degree (rad)
+
+// Sonar Model
+const double SONAR_CONE = 0.21;		// Half-angle (rad)
+const uint8_t SONAR_RAYS = 5;
+const double SONAR_RANGE = 3.0;		// (m)
+const double SONAR_INCIDENCE = 0.766;	// Min cos(incidence)
+const double SONAR_NOISE = 0.005;	// (m)
+const double SONAR_DROPOUT = 0.02;
+
+// Flame and Fan Model
+const double FLAME_INTENSITY = 323;	// At 1 m on axis
+const double FLAME_LOBE = 0.2;		// Sensor lobe width (rad)
+const double FLAME_NOISE = 2.0;		// (ADC)
+const double FAN_ANGLE = 0.25;		// Max blowing angle (rad)
+const double FAN_RANGE = 0.6;		// (m)
+
+// Fixed Analog Readings (ADC)
+const int BATTERY_READING = 818;	// 12 V
+const int CLIFF_READING = 100;		// Floor
+
+// Matlab Stand-in (us)
+const uint32_t CONNECT_TIME = 500000;
+const uint32_t GETDATA_PERIOD = 100000;
+
+// FireBot States
+const uint8_t STATE_BOOT = 0;
+const uint8_t STATE_AT_HOME = 15;
+const uint8_t STATE_FAULT = 16;
+
+// Pins
+const uint8_t PIN_FLAME = A0;
+const uint8_t PIN_BATTERY = A1;
+const uint8_t PIN_MOTOR_L = 4;
+const uint8_t PIN_MOTOR_R = 5;
+const uint8_t PIN_PAN = 6;
+const uint8_t PIN_TILT = 7;
+const uint8_t PIN_SONAR_F = 42;
+
+// Capture Port (Serial2)
+const uint8_t PORT_CAPTURE = 2;
+
+// Firmware RAM which survives a reset (.noinit)
+namespace Checkpoint {
+	extern Record ramCopy;
+	extern uint32_t runMarker;
+}
+
+//**************************************************************/
+// GEOMETRY
+//**************************************************************/
+
+//!b Point or vector (x, y) (m).
+struct Point {
+	double x, y;
+	Point(double x = 0, double y = 0) : x(x), y(y) {}
+	Point operator+(const Point& p) const { return Point(x + p.x, y + p.y); }
+	Point operator-(const Point& p) const { return Point(x - p.x, y - p.y); }
+	Point operator*(double k) const { return Point(x * k, y * k); }
+};
+
+double dot(const Point& a, const Point& b) {
+	return a.x * b.x + a.y * b.y;
+}
+
+double norm(const Point& a) {
+	return hypot(a.x, a.y);
+}
+
+//!b Returns unit vector of a heading (clockwise from +y).
+Point heading(double h) {
+	return Point(sin(h), cos(h));
+}
+
+//!b Returns an angle wrapped to [-pi, pi].
+double wrap(double a) {
+	return atan2(sin(a), cos(a));
+}
+
+//!b Axis-aligned box (m).
+struct Box {
+	double x0, y0, x1, y1;
+};
+
+//!b Returns distance between two boxes (0 if they overlap).
+double gap(const Box& a, const Box& b) {
+	double dx = fmax(0.0, fmax(a.x0 - b.x1, b.x0 - a.x1));
+	double dy = fmax(0.0, fmax(a.y0 - b.y1, b.y0 - a.y1));
+	return hypot(dx, dy);
+}
+
+//!b Returns distance from a point to a box (0 inside).
+double gap(const Point& p, const Box& b) {
+	double dx = fmax(0.0, fmax(b.x0 - p.x, p.x - b.x1));
+	double dy = fmax(0.0, fmax(b.y0 - p.y, p.y - b.y1));
+	return hypot(dx, dy);
+}
+
+//!b Wall face from a to b.
+struct Segment {
+	Point a, b;
+};
+
+//!b Returns distance from a point to a segment.
+double gap(const Point& p, const Segment& s) {
+	Point d = s.b - s.a;
+	double t = constrain(dot(p - s.a, d) / dot(d, d), 0.0, 1.0);
+	return norm(p - (s.a + d * t));
+}
+
+//**************************************************************/
+// FIELD
+//**************************************************************/
+
+std::mt19937 rng;
+
+double uniform(double a, double b) {
+	return std::uniform_real_distribution<double>(a, b)(rng);
+}
+
+double normal(double sd) {
+	return std::normal_distribution<double>(0, sd)(rng);
+}
+
+//!b Writes or reads a whole block through a pipe.
+//!d Returns false if the pipe closed first.
+bool pipeIo(int fd, void* p, size_t n, bool send) {
+	uint8_t* bytes = (uint8_t*)p;
+	while(n > 0) {
+		ssize_t k = send ? write(fd, bytes, n) : read(fd, bytes, n);
+		if(k <= 0) return false;
+		bytes += k;
+		n -= k;
+	}
+	return true;
+}
+
+//!b Random field with walls, obstacles, and a candle.
+struct Field {
+	Box arena;					// Inner faces of outer walls
+	std::vector<Box> boxes;		// Islands and peninsulas
+	std::vector<Segment> walls;	// All wall faces
+	uint8_t islands = 0;
+	uint8_t peninsulas = 0;
+	Point candle;
+	double flameZ = 0;			// (m)
+
+	void generate();
+	bool clear(const Box&, bool);
+	void addFaces(const Box&);
+	bool collides(const Point&, double, Point&);
+	double cast(const Point&, const Point&, bool&);
+	bool visible(const Point&, const Point&);
+};
+
+//!b Generates a field by rejection sampling.
+void Field::generate() {
+	double w = uniform(ARENA_MIN, ARENA_MAX);
+	double h = uniform(ARENA_MIN, ARENA_MAX);
+	arena.x0 = -0.23 + uniform(-0.03, 0.03);
+	arena.y0 = -uniform(0.2, 0.4);
+	arena.x1 = arena.x0 + w;
+	arena.y1 = arena.y0 + h;
+	addFaces(arena);
+
+	// Peninsulas from the outer walls
+	uint8_t n = std::uniform_int_distribution<int>(0, 2)(rng);
+	for(uint16_t tries = 0; peninsulas < n && tries < 100; tries++) {
+		double len = uniform(0.4, 0.9);
+		double t = 0.05;
+		Box b;
+		switch(rng() % 4) {
+			case 0:
+				b.x0 = arena.x0; b.x1 = arena.x0 + len;
+				b.y0 = uniform(arena.y0 + CORRIDOR, arena.y1 - CORRIDOR - t);
+				b.y1 = b.y0 + t;
+				break;
+			case 1:
+				b.x1 = arena.x1; b.x0 = arena.x1 - len;
+				b.y0 = uniform(arena.y0 + CORRIDOR, arena.y1 - CORRIDOR - t);
+				b.y1 = b.y0 + t;
+				break;
+			case 2:
+				b.y0 = arena.y0; b.y1 = arena.y0 + len;
+				b.x0 = uniform(arena.x0 + CORRIDOR, arena.x1 - CORRIDOR - t);
+				b.x1 = b.x0 + t;
+				break;
+			default:
+				b.y1 = arena.y1; b.y0 = arena.y1 - len;
+				b.x0 = uniform(arena.x0 + CORRIDOR, arena.x1 - CORRIDOR - t);
+				b.x1 = b.x0 + t;
+				break;
+		}
+		if(!clear(b, true)) continue;
+		boxes.push_back(b);
+		addFaces(b);
+		peninsulas++;
+	}
+
+	// Islands
+	n = std::uniform_int_distribution<int>(1, 3)(rng);
+	for(uint16_t tries = 0; islands < n && tries < 100; tries++) {
+		double bw = uniform(0.2, 0.6);
+		double bh = uniform(0.2, 0.6);
+		Box b;
+		b.x0 = uniform(arena.x0, arena.x1 - bw);
+		b.y0 = uniform(arena.y0, arena.y1 - bh);
+		b.x1 = b.x0 + bw;
+		b.y1 = b.y0 + bh;
+		if(!clear(b, false)) continue;
+		boxes.push_back(b);
+		addFaces(b);
+		islands++;
+	}
+
+	// Candle
+	while(true) {
+		candle = Point(uniform(arena.x0, arena.x1),
+			uniform(arena.y0, arena.y1));
+		bool ok = norm(candle) >= CANDLE_START_MIN;
+		for(const Segment& s : walls) {
+			ok = ok && gap(candle, s) >= CANDLE_WALL_MIN;
+		}
+		if(ok) break;
+	}
+	flameZ = uniform(0.15, 0.35);
+}
+
+//!b Returns true if a new obstacle leaves room to drive.
+//!i Obstacle
+//!i True if it is a peninsula (touches an outer wall)
+bool Field::clear(const Box& b, bool peninsula) {
+	if(gap(Point(), b) < START_CLEAR) return false;
+	for(const Box& o : boxes) {
+		if(gap(b, o) < CORRIDOR) return false;
+	}
+	double wallGap = fmin(
+		fmin(b.x0 - arena.x0, arena.x1 - b.x1),
+		fmin(b.y0 - arena.y0, arena.y1 - b.y1));
+	if(!peninsula) return wallGap >= CORRIDOR;
+	double across = fmax(b.x1 - b.x0, b.y1 - b.y0);
+	double room = (b.x1 - b.x0 > b.y1 - b.y0) ?
+		(arena.x1 - arena.x0) : (arena.y1 - arena.y0);
+	return room - across >= CORRIDOR;
+}
+
+//!b Adds the four faces of a box to the walls.
+void Field::addFaces(const Box& b) {
+	Point p[4] = {
+		Point(b.x0, b.y0), Point(b.x1, b.y0),
+		Point(b.x1, b.y1), Point(b.x0, b.y1)};
+	for(uint8_t i = 0; i < 4; i++) {
+		walls.push_back({p[i], p[(i + 1) % 4]});
+	}
+}
+
+//!b Returns true if a circle touches a wall or the candle.
+//!i Centre (m)
+//!i Radius (m)
+//!i Unit normal of the nearest contact, away from it (output)
+bool Field::collides(const Point& p, double r, Point& n) {
+	double nearest = norm(p - candle) - CANDLE_RADIUS;
+	n = (p - candle) * (1 / norm(p - candle));
+	for(const Segment& s : walls) {
+		double d = gap(p, s);
+		if(d < nearest) {
+			Point e = s.b - s.a;
+			double t = constrain(dot(p - s.a, e) / dot(e, e), 0.0, 1.0);
+			n = (p - (s.a + e * t)) * (1 / d);
+			nearest = d;
+		}
+	}
+	return nearest < r;
+}
+
+//!b Returns distance along a ray to the first wall or candle.
+//!i Ray origin (m)
+//!i Ray direction (unit)
+//!i True if the surface faces the ray within the sonar
+//!i incidence limit (output)
+//!d Returns INFINITY if nothing is hit.
+double Field::cast(const Point& p, const Point& d, bool& echo) {
+	double best = INFINITY;
+	echo = false;
+	for(const Segment& s : walls) {
+		Point e = s.b - s.a;
+		double den = d.x * e.y - d.y * e.x;
+		if(fabs(den) < 1e-12) continue;
+		Point q = s.a - p;
+		double t = (q.x * e.y - q.y * e.x) / den;
+		double u = (q.x * d.y - q.y * d.x) / den;
+		if(t > 0 && t < best && u >= 0 && u <= 1) {
+			best = t;
+			echo = fabs(d.x * e.y - d.y * e.x) / norm(e)
+				>= SONAR_INCIDENCE;
+		}
+	}
+	Point c = p - candle;
+	double b = dot(c, d);
+	double disc = b * b - dot(c, c) + CANDLE_RADIUS * CANDLE_RADIUS;
+	if(disc >= 0) {
+		double t = -b - sqrt(disc);
+		if(t > 0 && t < best) {
+			best = t;
+			echo = true;	// Round, so always echoes
+		}
+	}
+	return best;
+}
+
+//!b Returns true if no wall lies between two points.
+bool Field::visible(const Point& a, const Point& b) {
+	Point d = b - a;
+	double len = norm(d);
+	for(const Segment& s : walls) {
+		Point e = s.b - s.a;
+		double den = d.x * e.y - d.y * e.x;
+		if(fabs(den) < 1e-12) continue;
+		Point q = s.a - a;
+		double t = (q.x * e.y - q.y * e.x) / den;
+		double u = (q.x * d.y - q.y * d.x) / den;
+		if(t > 0 && t < 1 && u >= 0 && u <= 1) return false;
+	}
+	return len > 0;
+}
+
+//**************************************************************/
+// ROBOT MODEL
+//**************************************************************/
+
+//!b Robot and field model behind the library shims.
+class Sim : public Host::Hardware {
+public:
+	Field field;
+	Point pos;				// True VTC position (m)
+	double h = 0;			// True heading (rad)
+	uint16_t collisions = 0;
+	bool lit = true;		// Candle burning
+	FILE* captureLog = 0;	// Capture port bytes (or null)
+	uint32_t outputs = 2166136261u;	// Command digest (FNV-1a)
+	bool wasReset = false;
+	double resumeTime = -1;	// Reset to first drive command (s)
+
+	void setup();
+	void sync();
+	void matlab();
+	void reset();
+	bool transfer(int, bool);
+	int analogRead(uint8_t) override;
+	void serialWrite(uint8_t, uint8_t) override;
+	void motorVoltage(uint8_t, float) override;
+	float encoderAngle(uint8_t) override;
+	float imuHeading() override;
+	float sonar(uint8_t) override;
+	void servoAngle(uint8_t, float) override;
+	void fanSpeed(float) override;
+private:
+	uint32_t simUs = 0;		// Model time (us)
+	double vL = 0, vR = 0;	// Wheel speeds (m/s)
+	double aL = 0, aR = 0;	// Wheel angles (rad)
+	double uL = 0, uR = 0;	// Motor voltages (V)
+	double gL = 1, gR = 1;	// Wheel gains
+	double pan = 0, tilt = 0, fan = 0;
+	double imuOffset = 0;	// (rad)
+	double imuBias = 0;		// (rad)
+	double flicker = 0;		// Modulation depth
+	double flickerHz = 0;
+	double phase = 0;		// (rad)
+	double blow = 0;		// Time blown on (s)
+	double blowNeeded = 0;	// (s)
+	bool touching = false;
+	bool sentConnect = false;
+	bool linked = false;
+	uint32_t nextData = 0;	// (us)
+
+	void step(double);
+	void digest(uint8_t, float);
+	double wheel(double, double, double);
+	Point sensor(double&);
+	bool aimAt(double&, double&);
+};
+
+//!b Draws the field and model parameters for a run.
+void Sim::setup() {
+	field.generate();
+	gL = 1 + uniform(-WHEEL_MISMATCH, WHEEL_MISMATCH);
+	gR = 1 + uniform(-WHEEL_MISMATCH, WHEEL_MISMATCH);
+	imuOffset = uniform(-PI, PI);
+	flicker = uniform(0.02, 0.08);
+	flickerHz = uniform(6, 11);
+	phase = uniform(0, TWO_PI);
+	blowNeeded = uniform(0.5, 2.0);
+}
+
+//!b Models a reset of the robot's processor.
+//!d The motors and fan stop and the encoder counts restart from
+//!d zero. The IMU, servos, and Matlab keep running.
+void Sim::reset() {
+	uL = uR = fan = 0;
+	aL = aR = 0;
+	wasReset = true;
+}
+
+//!b Sends or receives the model state through a pipe.
+//!i Pipe
+//!i True to send, false to receive
+//!d The field and model parameters are left out, as both ends
+//!d drew them from the same seed. Returns false if the pipe
+//!d closed first.
+bool Sim::transfer(int fd, bool send) {
+	struct Part { void* p; size_t n; } parts[] = {
+		{&pos, sizeof(pos)}, {&h, sizeof(h)},
+		{&collisions, sizeof(collisions)}, {&lit, sizeof(lit)},
+		{&outputs, sizeof(outputs)}, {&simUs, sizeof(simUs)},
+		{&vL, sizeof(vL)}, {&vR, sizeof(vR)},
+		{&aL, sizeof(aL)}, {&aR, sizeof(aR)},
+		{&uL, sizeof(uL)}, {&uR, sizeof(uR)},
+		{&pan, sizeof(pan)}, {&tilt, sizeof(tilt)}, {&fan, sizeof(fan)},
+		{&imuBias, sizeof(imuBias)}, {&phase, sizeof(phase)},
+		{&blow, sizeof(blow)}, {&touching, sizeof(touching)},
+		{&sentConnect, sizeof(sentConnect)}, {&linked, sizeof(linked)},
+		{&nextData, sizeof(nextData)},
+	};
+	for(const Part& part : parts) {
+		if(!pipeIo(fd, part.p, part.n, send)) return false;
+	}
+	return true;
+}
+
+//!b Advances the model to the simulated clock.
+//!d Called before every hardware access, so the model also moves
+//!d during blocking calls such as a front sonar ping.
+void Sim::sync() {
+	while(simUs < Host::timeUs) {
+		uint32_t us = Host::timeUs - simUs;
+		if(us > STEP) us = STEP;
+		step(us * 1e-6);
+		simUs += us;
+	}
+}
+
+//!b Integrates the model over one step.
+void Sim::step(double dt) {
+
+	// Wheels and pose
+	vL = wheel(vL, uL * gL, dt);
+	vR = wheel(vR, uR * gR, dt);
+	aL += vL * dt / RobotDims::wheelRadius;
+	aR += vR * dt / RobotDims::wheelRadius;
+	double dh = (vL - vR) / TRACK * dt;
+	Point move = heading(h + 0.5 * dh) * ((vL + vR) * 0.5 * dt);
+	h += dh;
+	Point n;
+	if(field.collides(pos + move, ROBOT_RADIUS, n)) {
+		if(!touching) collisions++;
+		touching = true;
+		move = move - n * fmin(0.0, dot(move, n));	// Slide along
+		if(!field.collides(pos + move, ROBOT_RADIUS, n)) pos = pos + move;
+	} else {
+		pos = pos + move;
+		touching = false;
+	}
+	imuBias += normal(IMU_DRIFT * sqrt(dt));
+
+	// Flicker and fan
+	phase += TWO_PI * flickerHz * dt + normal(sqrt(dt) * 3.0);
+	double off, dist;
+	if(lit && fan > 0.5 && aimAt(off, dist) &&
+		off < FAN_ANGLE && dist < FAN_RANGE)
+	{
+		blow += dt;
+		if(blow >= blowNeeded) lit = false;
+	}
+}
+
+//!b Returns wheel speed after a step (m/s).
+//!i Speed (m/s)
+//!i Voltage (V)
+//!i Step (s)
+double Sim::wheel(double v, double u, double dt) {
+	double vss = (fabs(u) > WHEEL_KS) ?
+		(u - copysign(WHEEL_KS, u)) / WHEEL_KV : 0;
+	return v + (vss - v) * dt / WHEEL_TAU;
+}
+
+//!b Returns flame sensor position and sets its height (m).
+//!d Uses the pan-tilt geometry of computeFlamePosition().
+Point Sim::sensor(double& z) {
+	z = RobotDims::dBTz + RobotDims::dTS * cos(tilt);
+	double back = RobotDims::dBTy + RobotDims::dTS * sin(tilt);
+	return pos - heading(h + pan) * back;
+}
+
+//!b Finds the flame relative to where the pan-tilt points.
+//!i Off-axis angle (rad) (output)
+//!i Distance (m) (output)
+//!d Returns false if a wall blocks the line of sight.
+bool Sim::aimAt(double& off, double& dist) {
+	double z;
+	Point s = sensor(z);
+	Point d = field.candle - s;
+	double across = norm(d);
+	double a = wrap(atan2(d.x, d.y) - (h + pan));
+	double b = atan2(field.flameZ - z, across) - tilt;
+	off = hypot(a, b);
+	dist = hypot(across, field.flameZ - z);
+	return field.visible(s, field.candle - d * (CANDLE_RADIUS / across));
+}
+
+//!b Plays the Matlab side of the link.
+//!d Connects after a short wait, then polls for data at the rate
+//!d RobotConsole does once the robot has answered.
+void Sim::matlab() {
+	if(!sentConnect && Host::timeUs >= CONNECT_TIME) {
+		Serial.push(0x01);
+		sentConnect = true;
+	}
+	if(linked && Host::timeUs >= nextData) {
+		Serial.push(0x02);
+		nextData += GETDATA_PERIOD;
+	}
+}
+
+//!b Returns the model's analog readings (ADC).
+int Sim::analogRead(uint8_t pin) {
+	sync();
+	switch(pin) {
+		case PIN_FLAME: {
+			double off, dist, I = 0;
+			if(lit && aimAt(off, dist)) {
+				I = FLAME_INTENSITY / (dist * dist) *
+					exp(-0.5 * sq(off / FLAME_LOBE)) *
+					(1 + flicker * sin(phase));
+			}
+			double x = 1023 - 1000 * (1 - exp(-I / 1000)) +
+				normal(FLAME_NOISE);
+			return constrain((int)lround(x), 0, 1023);
+		}
+		case PIN_BATTERY: return BATTERY_READING;
+		default: return CLIFF_READING;
+	}
+}
+
+//!b Watches for the connect reply from the robot, and logs the
+//!b capture port.
+void Sim::serialWrite(uint8_t port, uint8_t b) {
+	if(port == 0 && sentConnect && !linked && b == 0x01) {
+		linked = true;
+		nextData = Host::timeUs;
+	}
+	if(port == PORT_CAPTURE && captureLog) fputc(b, captureLog);
+}
+
+void Sim::motorVoltage(uint8_t pin, float v) {
+	sync();
+	digest(pin, v);
+	if(wasReset && resumeTime < 0 && v != 0) {
+		resumeTime = (Host::timeUs - Host::resetUs) * 1e-6;
+	}
+	if(pin == PIN_MOTOR_L) uL = v;
+	if(pin == PIN_MOTOR_R) uR = v;
+}
+
+void Sim::fanSpeed(float s) {
+	digest(0, s);
+	fan = s;
+}
+
+//!b Adds a motor or fan command to the output digest.
+//!i Motor pin (0 for the fan)
+//!i Command
+void Sim::digest(uint8_t pin, float v) {
+	uint8_t bytes[5] = {pin};
+	memcpy(bytes + 1, &v, sizeof(v));
+	for(uint8_t i = 0; i < 5; i++) {
+		outputs = (outputs ^ bytes[i]) * 16777619u;
+	}
+}
+
+float Sim::encoderAngle(uint8_t pin) {
+	sync();
+	return (pin == PIN_MOTOR_L) ? aL : aR;
+}
+
+float Sim::imuHeading() {
+	sync();
+	double read = h + imuOffset + imuBias + normal(IMU_NOISE);
+	return IMU_LSB * round(read / IMU_LSB);
+}
+
+//!b Returns range from a sonar face (m) (0 if no echo).
+//!d Trigger pins run front, back, left, right from pin 42.
+float Sim::sonar(uint8_t trigPin) {
+	sync();
+	const double angle[4] = {0, PI, -HALF_PI, HALF_PI};
+	const float* radius[4] = {
+		&RobotDims::sonarRadiusF, &RobotDims::sonarRadiusB,
+		&RobotDims::sonarRadiusL, &RobotDims::sonarRadiusR};
+	uint8_t i = trigPin - PIN_SONAR_F;
+	if(i > 3) return 0;
+	double a = h + angle[i];
+	Point p = pos + heading(a) * *radius[i];
+	double best = INFINITY;
+	for(uint8_t r = 0; r < SONAR_RAYS; r++) {
+		double ray = a + SONAR_CONE * (2.0 * r / (SONAR_RAYS - 1) - 1);
+		bool echo;
+		double d = field.cast(p, heading(ray), echo);
+		if(echo && d < best) best = d;
+	}
+	if(best > SONAR_RANGE || uniform(0, 1) < SONAR_DROPOUT) return 0;
+	return fmax(0.0, best + normal(SONAR_NOISE));
+}
+
+void Sim::servoAngle(uint8_t pin, float a) {
+	sync();
+	if(pin == PIN_PAN) pan = a;
+	if(pin == PIN_TILT) tilt = a;
+}
+
+//**************************************************************/
+// RUNS
+//**************************************************************/
+
+const char* HEADER =
+	"date,state,faultCode,timeToFlame,timeToExtinguish,timeToHome,"
+	"homeError,flameX,flameY,flameZ,bootTime,resumes,"
+	"seed,outcome,trueHomeError,flameError,collisions,extinguished,"
+	"islands,peninsulas,resetTime,resumeTime\n";
+
+//!b Copy of a run which takes it over after a reset.
+//!d Forked before the firmware starts, so it still has the
+//!d firmware's initial state, as the robot does after a reset.
+//!d At the reset it is handed the clock, .noinit RAM, EEPROM,
+//!d random stream, and model, and logs the run's row in place of
+//!d the original.
+struct Twin {
+	pid_t pid = 0;		// Twin process (in the original)
+	int fd = -1;		// Hand-over pipe
+
+	bool split(Sim&);
+	void handOver(Sim&);
+	void cancel();
+};
+
+//!b Sends or receives what survives a reset through a pipe.
+//!d Returns false if the pipe closed first.
+bool transferReset(int fd, Sim& sim, bool send) {
+	std::stringstream stream;
+	std::string state;
+	if(send) {
+		stream << rng;
+		state = stream.str();
+	}
+	uint32_t n = state.size();
+	if(!pipeIo(fd, &n, sizeof(n), send)) return false;
+	state.resize(n);
+	if(!pipeIo(fd, &state[0], n, send) ||
+		!pipeIo(fd, &Host::timeUs, sizeof(Host::timeUs), send) ||
+		!pipeIo(fd, Host::eeprom, sizeof(Host::eeprom), send) ||
+		!pipeIo(fd, &Checkpoint::ramCopy, sizeof(Checkpoint::Record),
+			send) ||
+		!pipeIo(fd, &Checkpoint::runMarker, sizeof(uint32_t), send) ||
+		!sim.transfer(fd, send))
+	{
+		return false;
+	}
+	if(!send) {
+		stream.str(state);
+		stream >> rng;
+	}
+	return true;
+}
+
+//!b Forks the twin, which waits for a reset.
+//!d Returns true in the twin once it has taken over after the
+//!d reset. The twin exits if the run ends first.
+bool Twin::split(Sim& sim) {
+	int fds[2];
+	fflush(0);
+	if(pipe(fds) != 0) return false;
+	pid = fork();
+	if(pid > 0) {
+		close(fds[0]);
+		fd = fds[1];
+		return false;
+	}
+	if(pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		pid = 0;
+		return false;
+	}
+	close(fds[1]);
+	if(!transferReset(fds[0], sim, false)) _exit(0);
+	close(fds[0]);
+	Host::resetUs = Host::timeUs;
+	sim.reset();
+	return true;
+}
+
+//!b Resets the robot by handing the run to the twin.
+//!d Waits for the twin to finish the run.
+void Twin::handOver(Sim& sim) {
+	fflush(0);
+	transferReset(fd, sim, true);
+	close(fd);
+	waitpid(pid, 0, 0);
+	pid = 0;
+}
+
+//!b Ends the twin of a run which finished before the reset.
+void Twin::cancel() {
+	if(pid == 0) return;
+	close(fd);
+	waitpid(pid, 0, 0);
+	pid = 0;
+}
+
+//!b Runs one mission and returns its CSV row.
+//!i Seed
+//!i Time limit (s)
+//!i Reset time (s) (negative for none)
+//!i Per-loop pose log (or null)
+//!i Capture port log (or null)
+//!d A run that times out logs fault code -1, which MissionReport
+//!d counts as neither home nor a fault. A run that was reset
+//!d returns an empty row, as its twin logs the row.
+std::string run(uint32_t seed, double limit, double resetAt,
+	FILE* poseLog, FILE* captureLog)
+{
+	rng.seed(seed);
+	Sim sim;
+	sim.setup();
+	sim.captureLog = captureLog;
+	Host::hardware = &sim;
+	if(poseLog) {
+		const Field& f = sim.field;
+		fprintf(stderr, "Arena %.3f %.3f %.3f %.3f\n",
+			f.arena.x0, f.arena.y0, f.arena.x1, f.arena.y1);
+		for(const Box& b : f.boxes) {
+			fprintf(stderr, "Box %.3f %.3f %.3f %.3f\n",
+				b.x0, b.y0, b.x1, b.y1);
+		}
+		fprintf(stderr, "Candle %.3f %.3f %.3f\n",
+			f.candle.x, f.candle.y, f.flameZ);
+		fprintf(poseLog, "t,state,wallState,x,y,heading,"
+			"odoX,odoY,odoHeading,flameLit\n");
+	}
+
+	Twin twin;
+	if(resetAt >= 0) twin.split(sim);
+	FireBot::setup();
+	uint8_t state = STATE_BOOT;
+	uint32_t loops = 1;		// Setup is captured as a loop
+	while(state != STATE_AT_HOME && state != STATE_FAULT &&
+		Host::timeUs < limit * 1e6)
+	{
+		if(twin.pid != 0 && Host::timeUs >= resetAt * 1e6) {
+			twin.handOver(sim);
+			return "";
+		}
+		Host::advance(4000 + (uint32_t)uniform(0, 2000));
+		sim.sync();
+		sim.matlab();
+		FireBot::loop();
+		state = FireBot::getState();
+		loops++;
+		if(poseLog) {
+			fprintf(poseLog, "%.3f,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%d\n",
+				Host::timeUs * 1e-6, state, WallFollower::getState(),
+				sim.pos.x, sim.pos.y, sim.h, Odometer::position.x,
+				Odometer::position.y, Odometer::heading, sim.lit);
+		}
+	}
+
+	twin.cancel();
+	if(captureLog) {
+		fprintf(stderr, "Captured %u loops, final state %u, "
+			"outputs %08X\n", loops, state, sim.outputs);
+	}
+
+	// Mission statistics as RobotConsole logs them, then truth
+	const char* outcome = (state == STATE_AT_HOME) ? "home" :
+		(state == STATE_FAULT) ? "fault" : "timeout";
+	int faultCode = (state == STATE_FAULT || state == STATE_AT_HOME) ?
+		Mission::faultCode : -1;
+	const Vec3& f = FireBot::flamePos;
+	double flameError = -1;
+	if(Mission::time(Mission::EVENT_EXTINGUISHED) >= 0) {
+		flameError = sqrt(sq(f.x - sim.field.candle.x) +
+			sq(f.y - sim.field.candle.y) + sq(f.z - sim.field.flameZ));
+	}
+	char row[512];
+	snprintf(row, sizeof(row),
+		"sim,%u,%d,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f,%.3f,%u,"
+		"%u,%s,%.4f,%.4f,%u,%d,%u,%u,%.3f,%.3f\n",
+		state, faultCode,
+		Mission::time(Mission::EVENT_FLAME_FOUND),
+		Mission::time(Mission::EVENT_EXTINGUISHED),
+		Mission::time(Mission::EVENT_AT_HOME),
+		Mission::homeError, f.x, f.y, f.z,
+		Mission::bootTime, Mission::resumes,
+		seed, outcome, norm(sim.pos), flameError, sim.collisions,
+		!sim.lit, sim.field.islands, sim.field.peninsulas,
+		sim.wasReset ? Host::resetUs * 1e-6 : -1, sim.resumeTime);
+	return row;
+}
+
+//!b Running child process.
+struct Job {
+	pid_t pid;
+	int fd;			// Read end of its row pipe
+	uint32_t index;
+};
+
+//!b Returns the row logged for a run that crashed.
+std::string crashRow(uint32_t seed) {
+	char row[128];
+	snprintf(row, sizeof(row), "sim,-1,-1,-1,-1,-1,-1,0,0,0,-1,0,"
+		"%u,crash,-1,-1,0,0,0,0,-1,-1\n", seed);
+	return row;
+}
+
+//!b Returns a field of a CSV row.
+double column(const std::string& row, uint8_t k) {
+	size_t p = 0;
+	for(uint8_t i = 0; i < k; i++) p = row.find(',', p) + 1;
+	return atof(row.c_str() + p);
+}
+
+//!b Prints outcome counts and medians to stderr.
+void summarize(const std::vector<std::string>& rows) {
+	uint32_t home = 0, fault = 0, timeout = 0, crash = 0;
+	uint32_t resets = 0, resumed = 0;
+	std::vector<double> metric[3];	// Flame, extinguish, home (s)
+	std::vector<double> error;		// True home error (m)
+	std::vector<double> resume;		// Reset to driving again (s)
+	for(const std::string& r : rows) {
+		if(column(r, 20) >= 0) {
+			resets++;
+			if(column(r, 11) > 0) resumed++;
+			if(column(r, 21) >= 0) resume.push_back(column(r, 21));
+		}
+		if(r.find(",home,") != std::string::npos) {
+			home++;
+			error.push_back(column(r, 14));
+		}
+		else if(r.find(",fault,") != std::string::npos) fault++;
+		else if(r.find(",timeout,") != std::string::npos) timeout++;
+		else crash++;
+		for(uint8_t m = 0; m < 3; m++) {
+			double t = column(r, 3 + m);
+			if(t >= 0) metric[m].push_back(t);
+		}
+	}
+	fprintf(stderr, "Runs %zu: home %u, fault %u, timeout %u, "
+		"crash %u\n", rows.size(), home, fault, timeout, crash);
+	if(resets > 0) {
+		fprintf(stderr, "Resets %u: resumed %u\n", resets, resumed);
+	}
+	const char* names[5] = {"Time to flame (s)",
+		"Time to extinguish (s)", "Time to home (s)",
+		"True home error (m)", "Time to resume (s)"};
+	for(uint8_t m = 0; m < 5; m++) {
+		std::vector<double>& v = (m < 3) ? metric[m] :
+			(m == 3) ? error : resume;
+		std::sort(v.begin(), v.end());
+		if(v.empty()) continue;
+		fprintf(stderr, "%-24s n %4zu  median %7.3f  p10 %7.3f  "
+			"p90 %7.3f\n", names[m], v.size(), v[v.size() / 2],
+			v[v.size() / 10], v[v.size() * 9 / 10]);
+	}
+}
+
+//**************************************************************/
+// MAIN
+//**************************************************************/
+
+//!b Runs missions in parallel and writes the mission log.
+//!d Options:
+//!d - -n Number of runs (100)
+//!d - -s First seed (1)
+//!d - -j Parallel runs (processor count)
+//!d - -t Time limit per run (300 s)
+//!d - -o Output CSV (stdout)
+//!d - -p Per-loop pose log of the first run
+//!d - -c Capture of the first run (FireBotSimCapture only)
+//!d - -r Reset the robot at a time in each run (s)
+int main(int argc, char** argv) {
+	uint32_t runs = 100, seed = 1;
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	double limit = 300;
+	const char* outName = 0;
+	const char* poseName = 0;
+	const char* captureName = 0;
+	double resetAt = -1;
+	int opt;
+	while((opt = getopt(argc, argv, "n:s:j:t:o:p:c:r:h")) != -1) {
+		switch(opt) {
+			case 'n': runs = atoi(optarg); break;
+			case 's': seed = atoi(optarg); break;
+			case 'j': jobs = atoi(optarg); break;
+			case 't': limit = atof(optarg); break;
+			case 'o': outName = optarg; break;
+			case 'p': poseName = optarg; break;
+			case 'c':
+				if(!CAPTURE_ENABLED) {
+					fprintf(stderr, "-c needs FireBotSimCapture\n");
+					return 1;
+				}
+				captureName = optarg;
+				break;
+			case 'r': resetAt = atof(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n runs] [-s seed] [-j jobs] "
+					"[-t limit] [-o out.csv] [-p pose.csv] "
+					"[-c capture.bin] [-r reset]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(jobs < 1) jobs = 1;
+
+	// Fork each run from this untouched process
+	std::vector<std::string> rows(runs);
+	std::vector<Job> running;
+	uint32_t next = 0;
+	while(next < runs || !running.empty()) {
+		if(next < runs && (long)running.size() < jobs) {
+			int fds[2];
+			if(pipe(fds) != 0) return 1;
+			pid_t pid = fork();
+			if(pid == 0) {
+				close(fds[0]);
+				FILE* poseLog = (next == 0 && poseName) ?
+					fopen(poseName, "w") : 0;
+				FILE* captureLog = (next == 0 && captureName) ?
+					fopen(captureName, "wb") : 0;
+				std::string row = run(seed + next, limit, resetAt,
+					poseLog, captureLog);
+				if(poseLog) fclose(poseLog);
+				if(captureLog) fclose(captureLog);
+				if(write(fds[1], row.data(), row.size()) < 0) _exit(1);
+				_exit(0);
+			}
+			close(fds[1]);
+			running.push_back({pid, fds[0], next++});
+			continue;
+		}
+		int status;
+		pid_t pid = wait(&status);
+		for(size_t k = 0; k < running.size(); k++) {
+			if(running[k].pid != pid) continue;
+			char buf[512];
+			ssize_t n = read(running[k].fd, buf, sizeof(buf));
+			uint32_t i = running[k].index;
+			rows[i] = (n > 0) ? std::string(buf, n) : crashRow(seed + i);
+			close(running[k].fd);
+			running.erase(running.begin() + k);
+			break;
+		}
+	}
+
+	FILE* out = outName ? fopen(outName, "w") : stdout;
+	if(!out) return 1;
+	fputs(HEADER, out);
+	for(const std::string& r : rows) fputs(r.c_str(), out);
+	if(outName) fclose(out);
+	summarize(rows);
+	return 0;
+}
@@ -0,0 +1,277 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FixedPidBench.cpp
+//!b Host benchmark and step response check of FixedPid.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Times FixedPid updates against a float controller of the same
+//!d form, and runs the DriveSystem wheel velocity, pivot turn, and
+//!d heading tracking steps of GainTuner.m with each. The plain
+//!d float PID is the PidController form FixedPid replaced, with
+//!d no derivative filter and no anti-windup. Step metrics are the
+//!d 10-90% rise time, overshoot, 2% settling time, and integral of
+//!d absolute error, plus the largest output difference between
+//!d FixedPid and the float controller of the same form.
+//!d
+//!d Host times come from a PC with an FPU, where float is cheap,
+//!d so they show the overhead of the float interface over the
+//!d Q-format one rather than the saving on the Mega. There, every
+//!d float operation is a soft-float library call while FixedPid
+//!d uses only 16 x 16 multiplies and shifts.
+
+#include <chrono>
+#include <stdio.h>
+#include "Arduino.h"
+#include "FixedPid.h"
+
+//**************************************************************/
+// FLOAT REFERENCE CONTROLLERS
+//**************************************************************/
+
+//!b FixedPid algorithm in float.
+class FloatPid {
+public:
+	FloatPid(float kp, float ki, float kd, float lo, float hi) :
+		kp(kp), ki(ki), kd(kd), lo(lo), hi(hi),
+		integral(0), derivative(0), last(0), begun(false)
+	{
+		if(ki == 0 || kp == 0) kb = ki;
+		else if(kd == 0) kb = ki / kp;
+		else kb = sqrt(ki / kd);
+		iMax = max(fabs(lo), fabs(hi));
+	}
+
+	float update(float e, float dt) {
+		if(!begun) { last = e; begun = true; dt = 0; }
+		if(dt > 0) {
+			derivative += ((e - last) / dt - derivative) / 4;
+		}
+		last = e;
+		integral = constrain(integral + ki * e * dt, -iMax, iMax);
+		float u = kp * e + integral + kd * derivative;
+		float uSat = constrain(u, lo, hi);
+		float back = kb * (uSat - u) * dt;
+		if((integral > 0 && back < 0) || (integral < 0 && back > 0)) {
+			float bled = integral + back;
+			integral = ((bled > 0) == (integral > 0)) ? bled : 0;
+		}
+		return uSat;
+	}
+
+private:
+	float kp, ki, kd, kb, lo, hi, iMax;
+	float integral, derivative, last;
+	bool begun;
+};
+
+//!b PidController form: no filter or anti-windup.
+class PlainPid {
+public:
+	PlainPid(float kp, float ki, float kd, float lo, float hi) :
+		kp(kp), ki(ki), kd(kd), lo(lo), hi(hi),
+		integral(0), last(0), begun(false) {}
+
+	float update(float e, float dt) {
+		if(!begun) { last = e; begun = true; }
+		integral += ki * e * dt;
+		float d = (dt > 0) ? (e - last) / dt : 0;
+		last = e;
+		return constrain(kp * e + integral + kd * d, lo, hi);
+	}
+
+private:
+	float kp, ki, kd, lo, hi;
+	float integral, last;
+	bool begun;
+};
+
+//**************************************************************/
+// UPDATE COST
+//**************************************************************/
+
+const uint32_t COST_UPDATES = 10000000;
+const uint16_t COST_ERRORS = 1024;
+float costErrors[COST_ERRORS];
+volatile float costSink;
+
+//!b Returns mean nanoseconds per update of a controller.
+template<class Pid, class Update>
+double cost(Pid& pid, Update update) {
+	auto start = std::chrono::steady_clock::now();
+	float sum = 0;
+	for(uint32_t n = 0; n < COST_UPDATES; n++) {
+		sum += update(pid, costErrors[n & (COST_ERRORS - 1)]);
+	}
+	auto end = std::chrono::steady_clock::now();
+	costSink = sum;
+	return std::chrono::duration<double, std::nano>(end - start)
+		.count() / COST_UPDATES;
+}
+
+//!b Prints update cost of each controller form.
+void printCosts() {
+	srand(1);
+	for(uint16_t n = 0; n < COST_ERRORS; n++) {
+		costErrors[n] = 0.5 * (rand() / (float)RAND_MAX - 0.5);
+	}
+	FixedPid<12> fixedPid(2.0, 0.005, 0.25, -0.15, 0.15);
+	FixedPid<12> fixedPidQ(2.0, 0.005, 0.25, -0.15, 0.15);
+	FloatPid floatPid(2.0, 0.005, 0.25, -0.15, 0.15);
+	PlainPid plainPid(2.0, 0.005, 0.25, -0.15, 0.15);
+	double fixedNs = cost(fixedPid, [](FixedPid<12>& p, float e) {
+		return p.update(e, 0.005);
+	});
+	double fixedQNs = cost(fixedPidQ, [](FixedPid<12>& p, float e) {
+		return (float)p.updateFixed(e * 4096, 5000);
+	});
+	double floatNs = cost(floatPid, [](FloatPid& p, float e) {
+		return p.update(e, 0.005);
+	});
+	double plainNs = cost(plainPid, [](PlainPid& p, float e) {
+		return p.update(e, 0.005);
+	});
+	printf("Update cost (host, ns)\n");
+	printf("  FixedPid float interface  %6.2f\n", fixedNs);
+	printf("  FixedPid Q-format         %6.2f\n", fixedQNs);
+	printf("  Float (same form)         %6.2f\n", floatNs);
+	printf("  Plain float PID           %6.2f\n", plainNs);
+	printf("\n");
+}
+
+//**************************************************************/
+// STEP RESPONSES
+//**************************************************************/
+
+// Plant Model (as GainTuner.m)
+const float DT = 0.005;			// Loop period (s)
+const float TAU = 0.08;			// Wheel velocity time constant (s)
+const float KV = 20.0;			// Motor V*s/m
+const float KS = 1.0;			// Friction voltage (V)
+const float DEADBAND = 0.005;	// Feedforward deadband (m/s)
+const float TRACK = 0.23;		// Wheel track width (m)
+const float HORIZON = 3.0;		// Simulated time (s)
+const uint16_t STEPS = HORIZON / DT;
+
+enum step_t {
+	STEP_WHEEL,
+	STEP_PIVOT,
+	STEP_TRACK,
+};
+
+struct Response {
+	float y[STEPS];		// Controlled variable
+	float u[STEPS];		// Left wheel controller output (V)
+};
+
+//!b Returns wheel feedforward voltage as in DriveSystem.
+float feedforward(float v) {
+	if(fabs(v) > DEADBAND) return KV * v + KS * (v > 0 ? 1 : -1);
+	else return KV * v;
+}
+
+//!b Returns steady-state wheel velocity for a voltage.
+float motor(float u) {
+	if(fabs(u) <= KS) return 0;
+	return (u - KS * (u > 0 ? 1 : -1)) / KV;
+}
+
+//!b Simulates one step with a controller form.
+//!i Step type
+//!i Controller factory: (kp, ki, kd, lo, hi)
+//!i Controller update: (pid, error)
+//!i Response (output)
+template<class Pid, class Make, class Update>
+void simulate(step_t step, Make make, Update update, Response& r) {
+	Pid wheelL = make(10.0, 40.0, 0.0, -9, 9);
+	Pid wheelR = make(10.0, 40.0, 0.0, -9, 9);
+	Pid heading = (step == STEP_PIVOT) ?
+		make(2.0, 0.005, 0.25, -0.15, 0.15) :
+		make(1.2, 0.02, 0.08, -0.15, 0.15);
+	float vt = (step == STEP_PIVOT) ? 0.0 : 0.2;
+	float ht = (step == STEP_WHEEL) ? 0.0 :
+		(step == STEP_PIVOT) ? HALF_PI : 0.2;
+	float vL = 0, vR = 0, h = 0;
+	for(uint16_t k = 0; k < STEPS; k++) {
+		r.y[k] = (step == STEP_WHEEL) ? vL : h;
+		float vDiff = update(heading, ht - h);
+		if(step == STEP_WHEEL) vDiff = 0;
+		float uL = update(wheelL, vt + vDiff - vL);
+		float uR = update(wheelR, vt - vDiff - vR);
+		r.u[k] = uL;
+		uL = constrain(feedforward(vt + vDiff) + uL, -12, 12);
+		uR = constrain(feedforward(vt - vDiff) + uR, -12, 12);
+		vL += DT / TAU * (motor(uL) - vL);
+		vR += DT / TAU * (motor(uR) - vR);
+		h += DT * (vL - vR) / TRACK;
+	}
+}
+
+//!b Prints step metrics of a response.
+//!i Row label
+//!i Response
+//!i Setpoint
+void printMetrics(const char* label, const Response& r, float target) {
+	int16_t rise10 = -1, rise90 = -1, settle = 0;
+	float peak = 0, iae = 0;
+	for(uint16_t k = 0; k < STEPS; k++) {
+		float y = r.y[k] / target;
+		if(rise10 < 0 && y >= 0.1) rise10 = k;
+		if(rise90 < 0 && y >= 0.9) rise90 = k;
+		if(y > peak) peak = y;
+		if(fabs(1 - y) > 0.02) settle = k + 1;
+		iae += fabs(target - r.y[k]) * DT;
+	}
+	float rise = (rise10 < 0 || rise90 < 0) ? NAN : (rise90 - rise10) * DT;
+	printf("  %-10s rise %5.3f s  over %5.2f%%  settle %5.3f s"
+		"  IAE %.5f\n",
+		label, rise, max(0.0, peak - 1) * 100, settle * DT, iae);
+}
+
+//!b Prints step comparison of the controller forms.
+//!i Step type
+//!i Step title
+//!i Setpoint
+void printStep(step_t step, const char* title, float target) {
+	static Response fixedR, floatR, plainR;
+	simulate<FixedPid<12>>(step,
+		[](float kp, float ki, float kd, float lo, float hi) {
+			return FixedPid<12>(kp, ki, kd, lo, hi);
+		},
+		[](FixedPid<12>& p, float e) { return p.update(e, DT); },
+		fixedR);
+	simulate<FloatPid>(step,
+		[](float kp, float ki, float kd, float lo, float hi) {
+			return FloatPid(kp, ki, kd, lo, hi);
+		},
+		[](FloatPid& p, float e) { return p.update(e, DT); },
+		floatR);
+	simulate<PlainPid>(step,
+		[](float kp, float ki, float kd, float lo, float hi) {
+			return PlainPid(kp, ki, kd, lo, hi);
+		},
+		[](PlainPid& p, float e) { return p.update(e, DT); },
+		plainR);
+	float uDiff = 0;
+	for(uint16_t k = 0; k < STEPS; k++) {
+		uDiff = max(uDiff, fabs(fixedR.u[k] - floatR.u[k]));
+	}
+	printf("%s step\n", title);
+	printMetrics("FixedPid", fixedR, target);
+	printMetrics("Float", floatR, target);
+	printMetrics("Plain", plainR, target);
+	printf("  FixedPid vs float output: max diff %.5f V\n\n", uDiff);
+}
+
+//**************************************************************/
+// MAIN
+//**************************************************************/
+
+int main() {
+	printCosts();
+	printStep(STEP_WHEEL, "Wheel velocity (0.2 m/s)", 0.2);
+	printStep(STEP_PIVOT, "Pivot turn (90 deg)", HALF_PI);
+	printStep(STEP_TRACK, "Heading tracking (0.2 rad)", 0.2);
+	return 0;
+}
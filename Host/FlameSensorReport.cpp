@@ -0,0 +1,222 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FlameSensorReport.cpp
+//!b Detection report of FlameSensor on synthetic traces.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Runs the FlameSensor code through FireBot's flame confirm
+//!d step on synthetic sensor traces, and reports how often each
+//!d kind of source is taken as a flame and how long the decision
+//!d takes. Each trial clears the sensor and runs loops of jittered
+//!d length, with occasional long loops, until the buffer is full
+//!d or too many samples are missed, as stateConfirmFlame() does.
+//!d Latency is from the clear to the decision.
+//!d
+//!d Candles are a mean level with flicker at 5 to 12 Hz whose
+//!d phase wanders, at three strengths. The other sources are what
+//!d the single threshold used to trip on: steady sunlight with a
+//!d slow drift, a reflection seen while the robot rocks to a stop,
+//!d a lamp with mains ripple, and a PWM-dimmed lamp whose ripple
+//!d aliases anywhere below 50 Hz. Every trace has sensor noise.
+//!d Trials are seeded, so reports can be diffed between revisions.
+
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include "Arduino.h"
+#include "Capture.h"
+#include "FlameSensor.h"
+
+//**************************************************************/
+// TRACE MODELS
+//**************************************************************/
+
+const uint16_t TRIALS = 2000;			// Trials per source
+const uint16_t FLAME_MISSED_MAX = 50;	// As FireBot (samples)
+std::mt19937 rng(1);
+
+//!b Returns a uniform random number in [a, b].
+float uniform(float a, float b) {
+	return std::uniform_real_distribution<float>(a, b)(rng);
+}
+
+//!b Returns a normal random number.
+float normal(float sd) {
+	return std::normal_distribution<float>(0, sd)(rng);
+}
+
+//!b Synthetic flame sensor source.
+struct Source {
+	enum type_t {
+		CANDLE_DRAFT,
+		CANDLE,
+		CANDLE_STILL,
+		SUNLIGHT,
+		ROCKING,
+		MAINS_LAMP,
+		PWM_LAMP,
+		NUM_TYPES,
+	};
+
+	type_t type;
+	float mean;		// (ADC)
+	float amp;		// Ripple amplitude (ADC)
+	float freq;		// Ripple frequency (Hz)
+	float decay;	// Rocking time constant (s)
+	float noise;	// Sensor noise (ADC)
+	float phase;	// (rad)
+	float lastT;	// (s)
+
+	//!b Draws a random source of a type.
+	Source(type_t type) : type(type), phase(uniform(0, TWO_PI)),
+		lastT(0)
+	{
+		mean = uniform(250, 700);
+		noise = uniform(1, 3);
+		decay = 0;
+		switch(type) {
+			case CANDLE_DRAFT: amp = uniform(15, 60); break;
+			case CANDLE: amp = uniform(5, 15); break;
+			case CANDLE_STILL: amp = uniform(1, 5); break;
+			case SUNLIGHT: amp = uniform(0, 20); break;
+			case ROCKING: amp = uniform(5, 40); break;
+			default: amp = uniform(5, 40); break;
+		}
+		switch(type) {
+			case SUNLIGHT: freq = uniform(0.05, 0.5); break;
+			case ROCKING:
+				freq = uniform(2, 8);
+				decay = uniform(0.1, 0.4);
+				break;
+			case MAINS_LAMP:
+				freq = ((rng() & 1) ? 100 : 120) * uniform(0.998, 1.002);
+				break;
+			case PWM_LAMP: freq = uniform(200, 2000); break;
+			default: freq = uniform(5, 12); break;
+		}
+	}
+
+	//!b Returns the ADC reading at a time.
+	//!i Time since the confirm started (s)
+	int read(float t) {
+		float x = mean + normal(noise);
+		switch(type) {
+			case CANDLE_DRAFT:
+			case CANDLE:
+			case CANDLE_STILL: {
+				float dt = t - lastT;
+				phase += TWO_PI * freq * dt + normal(sqrt(dt) * 3.0);
+				lastT = t;
+				x += amp * sin(phase) * (1 + 0.3 * normal(1));
+				break;
+			}
+			case ROCKING:
+				x += amp * exp(-t / decay) * sin(TWO_PI * freq * t + phase);
+				break;
+			default:
+				x += amp * sin(TWO_PI * freq * t + phase);
+				break;
+		}
+		return constrain((int)lround(x), 0, 1023);
+	}
+};
+
+const char* SOURCE_NAMES[Source::NUM_TYPES] = {
+	"Candle, draft",
+	"Candle",
+	"Candle, still air",
+	"Sunlight",
+	"Reflection, rocking",
+	"Mains lamp",
+	"PWM lamp",
+};
+
+Source* source = 0;
+uint32_t startUs = 0;
+
+//!b Hardware model answering the flame sensor pin.
+class Trace : public Host::Hardware {
+public:
+	int analogRead(uint8_t) override {
+		return source->read((Host::timeUs - startUs) * 1e-6);
+	}
+} trace;
+
+//**************************************************************/
+// CONFIRM TRIALS
+//**************************************************************/
+
+//!b Returns the next loop length (us).
+//!d Loops take 4 to 6 ms, with one in 200 taking 25 ms.
+uint32_t loopLength() {
+	if(uniform(0, 1) < 0.005) return 25000;
+	return 4000 + (uint32_t)uniform(0, 2000);
+}
+
+//!b Runs one confirm step on a source.
+//!i Source
+//!i Latency from clear to decision (s) (output)
+//!i True if too many samples were missed (output)
+//!d Returns true if the sensor reported a flame.
+bool confirm(Source& s, float& latency, bool& late) {
+	source = &s;
+	startUs = Host::timeUs;
+	FlameSensor::clear();
+	while(true) {
+		Host::advance(loopLength());
+		Capture::loop();
+		FlameSensor::loop();
+		late = FlameSensor::missed() > FLAME_MISSED_MAX;
+		if(late || FlameSensor::full()) break;
+	}
+	latency = (Host::timeUs - startUs) * 1e-6;
+	return !late && FlameSensor::flickering();
+}
+
+//!b Returns a percentile of sorted values.
+float percentile(const std::vector<float>& v, float p) {
+	if(v.empty()) return NAN;
+	return v[(size_t)(p * (v.size() - 1))];
+}
+
+//**************************************************************/
+// MAIN
+//**************************************************************/
+
+int main() {
+	Host::hardware = &trace;
+	Capture::setup();
+	FlameSensor::setup();
+	printf("%-20s %7s %7s %6s %12s %12s\n", "Source", "Trials",
+		"Flame", "Late", "Median (ms)", "95% (ms)");
+	uint32_t hits[2] = {0, 0}, trials[2] = {0, 0};
+	for(uint8_t t = 0; t < Source::NUM_TYPES; t++) {
+		bool isCandle = (t <= Source::CANDLE_STILL);
+		uint32_t flames = 0, lates = 0;
+		std::vector<float> latencies;
+		for(uint16_t n = 0; n < TRIALS; n++) {
+			Source s((Source::type_t)t);
+			float latency;
+			bool late;
+			if(confirm(s, latency, late)) flames++;
+			if(late) lates++;
+			latencies.push_back(latency);
+		}
+		std::sort(latencies.begin(), latencies.end());
+		hits[isCandle] += flames;
+		trials[isCandle] += TRIALS;
+		printf("%-20s %7u %6.1f%% %5.1f%% %12.0f %12.0f\n",
+			SOURCE_NAMES[t], TRIALS, 100.0 * flames / TRIALS,
+			100.0 * lates / TRIALS,
+			1000 * percentile(latencies, 0.5),
+			1000 * percentile(latencies, 0.95));
+	}
+	printf("\nDetection rate (candles)       %5.1f%%\n",
+		100.0 * hits[1] / trials[1]);
+	printf("False positive rate (others)   %5.1f%%\n",
+		100.0 * hits[0] / trials[0]);
+	return 0;
+}
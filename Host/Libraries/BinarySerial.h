@@ -0,0 +1,28 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t BinarySerial.h
+//!b Host shim of the BinarySerial library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class BinarySerial {
+public:
+	BinarySerial(HardwareSerial&, unsigned long);
+	void setup();
+	void flush();
+	int available();
+	byte readByte();
+	float readFloat();
+	void writeByte(byte);
+	void writeFloat(float);
+private:
+	HardwareSerial* port;
+};
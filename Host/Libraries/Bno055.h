@@ -0,0 +1,23 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Bno055.h
+//!b Host shim of the Bno055 library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+enum bno_mount_t { tlb };
+
+class Bno055 {
+public:
+	Bno055(bno_mount_t);
+	bool setup();
+	float heading();
+};
@@ -0,0 +1,22 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t BrushlessMotor.h
+//!b Host shim of the BrushlessMotor library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class BrushlessMotor {
+public:
+	BrushlessMotor(uint8_t, int, int);
+	void setup();
+	void arm();
+	void setSpeed(float);
+};
@@ -0,0 +1,36 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t DcMotor.h
+//!b Host shim of the DcMotor library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class DcMotor {
+public:
+	DcMotor(float, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, float);
+	void setup();
+	void enable();
+	void setVoltage(float);
+	void brake();
+	float encoderAngle();
+	void resetEncoder();
+	uint8_t getInterruptA();
+	uint8_t getInterruptB();
+	void isrA();
+	void isrB();
+private:
+	float vMax;
+	uint8_t pinPwm;
+	uint8_t pinA;
+	uint8_t pinB;
+	float cpr;
+	float zero;		// Wheel angle at last reset (rad)
+};
@@ -0,0 +1,20 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Hc06.h
+//!b Host shim of the Hc06 library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class Hc06 {
+public:
+	Hc06(HardwareSerial&, unsigned long);
+	bool setup();
+};
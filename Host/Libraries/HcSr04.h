@@ -0,0 +1,22 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t HcSr04.h
+//!b Host shim of the HcSr04 library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class HcSr04 {
+public:
+	HcSr04(uint8_t, uint8_t);
+	float dist();
+private:
+	uint8_t pinTrig;
+};
@@ -0,0 +1,33 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t HcSr04Array.h
+//!b Host shim of the HcSr04Array library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class HcSr04Array {
+public:
+	HcSr04Array(uint8_t, uint8_t*, uint8_t*);
+	void setup();
+	void begin();
+	uint8_t loop();
+	float get(uint8_t);
+	uint8_t getEchoPinId(uint8_t);
+	void isr();
+private:
+	static const uint8_t MAX_SENSORS = 8;
+	uint8_t n;
+	uint8_t* trigPins;
+	uint8_t* echoPins;
+	float dists[MAX_SENSORS];
+	uint8_t next;		// Sensor pinging (0-based)
+	uint32_t pingUs;	// Ping start (us)
+};
@@ -0,0 +1,22 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Led.h
+//!b Host shim of the Led library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class Led {
+public:
+	Led(uint8_t);
+	void setup();
+	void on();
+	void off();
+};
@@ -0,0 +1,280 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Libraries.cpp
+//!b Host shims of the ArduinoLibs libraries used by the robot.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Each shim keeps the library's interface and passes hardware
+//!d access to Host::hardware (see Arduino.h). Sensor timing is
+//!d modelled where the firmware depends on it: the sonar array
+//!d pings one sensor per 25 ms slot, a blocking ping waits for its
+//!d echo, and the servos move their open-loop estimates at the
+//!d commanded velocity. Encoders count in whole counts.
+
+#include "BinarySerial.h"
+#include "Bno055.h"
+#include "BrushlessMotor.h"
+#include "DcMotor.h"
+#include "Hc06.h"
+#include "HcSr04.h"
+#include "HcSr04Array.h"
+#include "Led.h"
+#include "OpenLoopServo.h"
+#include "PinChangeInt.h"
+
+//**************************************************************/
+// CONSTANTS
+//**************************************************************/
+
+namespace {
+	const uint32_t PING_SLOT = 25000;		// Array ping slot (us)
+	const uint32_t PING_TIMEOUT = 30000;	// No echo (us)
+	const float SPEED_OF_SOUND = 343.0;		// (m/s)
+}
+
+//**************************************************************/
+// BINARYSERIAL
+//**************************************************************/
+
+BinarySerial::BinarySerial(HardwareSerial& port, unsigned long) :
+	port(&port) {}
+
+void BinarySerial::setup() {}
+
+//!b Drops received bytes.
+void BinarySerial::flush() {
+	while(port->available()) port->read();
+}
+
+int BinarySerial::available() {
+	return port->available();
+}
+
+byte BinarySerial::readByte() {
+	return port->read();
+}
+
+//!b Reads a little-endian float.
+float BinarySerial::readFloat() {
+	float f;
+	uint8_t* bytes = (uint8_t*)&f;
+	for(uint8_t i = 0; i < 4; i++) bytes[i] = port->read();
+	return f;
+}
+
+void BinarySerial::writeByte(byte b) {
+	port->write(b);
+}
+
+//!b Writes a little-endian float.
+void BinarySerial::writeFloat(float f) {
+	uint8_t* bytes = (uint8_t*)&f;
+	for(uint8_t i = 0; i < 4; i++) port->write(bytes[i]);
+}
+
+//**************************************************************/
+// BNO055
+//**************************************************************/
+
+Bno055::Bno055(bno_mount_t) {}
+
+bool Bno055::setup() {
+	return true;
+}
+
+//!b Returns the modelled heading (rad).
+float Bno055::heading() {
+	return Host::hardware->imuHeading();
+}
+
+//**************************************************************/
+// BRUSHLESSMOTOR
+//**************************************************************/
+
+BrushlessMotor::BrushlessMotor(uint8_t, int, int) {}
+
+void BrushlessMotor::setup() {}
+
+void BrushlessMotor::arm() {}
+
+//!b Passes fan speed (0 to 1) to the hardware model.
+void BrushlessMotor::setSpeed(float s) {
+	Host::hardware->fanSpeed(s);
+}
+
+//**************************************************************/
+// DCMOTOR
+//**************************************************************/
+
+DcMotor::DcMotor(float vMax, uint8_t pinPwm, uint8_t, uint8_t,
+	uint8_t pinA, uint8_t pinB, float cpr) :
+	vMax(vMax), pinPwm(pinPwm), pinA(pinA), pinB(pinB), cpr(cpr),
+	zero(0) {}
+
+void DcMotor::setup() {}
+
+void DcMotor::enable() {}
+
+//!b Passes the saturated voltage to the motor model by PWM pin.
+void DcMotor::setVoltage(float v) {
+	Host::hardware->motorVoltage(pinPwm, constrain(v, -vMax, vMax));
+}
+
+void DcMotor::brake() {
+	Host::hardware->motorVoltage(pinPwm, 0);
+}
+
+//!b Returns wheel angle since the last reset in whole counts (rad).
+float DcMotor::encoderAngle() {
+	float count = TWO_PI / cpr;
+	float a = floor(Host::hardware->encoderAngle(pinPwm) / count);
+	return a * count - zero;
+}
+
+void DcMotor::resetEncoder() {
+	zero += encoderAngle();
+}
+
+uint8_t DcMotor::getInterruptA() {
+	return pinA;
+}
+
+uint8_t DcMotor::getInterruptB() {
+	return pinB;
+}
+
+void DcMotor::isrA() {}
+
+void DcMotor::isrB() {}
+
+//**************************************************************/
+// HC06
+//**************************************************************/
+
+Hc06::Hc06(HardwareSerial&, unsigned long) {}
+
+bool Hc06::setup() {
+	return true;
+}
+
+//**************************************************************/
+// HCSR04
+//**************************************************************/
+
+HcSr04::HcSr04(uint8_t pinTrig, uint8_t) : pinTrig(pinTrig) {}
+
+//!b Pings and returns the range (m) (0 if no echo).
+//!d Advances the clock by the echo time, as the real ping blocks.
+float HcSr04::dist() {
+	float d = Host::hardware->sonar(pinTrig);
+	Host::advance((d == 0) ? PING_TIMEOUT :
+		(uint32_t)(2e6 * d / SPEED_OF_SOUND));
+	return d;
+}
+
+//**************************************************************/
+// HCSR04ARRAY
+//**************************************************************/
+
+HcSr04Array::HcSr04Array(uint8_t n, uint8_t* trigPins,
+	uint8_t* echoPins) :
+	n(min(n, MAX_SENSORS)), trigPins(trigPins), echoPins(echoPins),
+	next(0), pingUs(0)
+{
+	for(uint8_t i = 0; i < MAX_SENSORS; i++) dists[i] = 0;
+}
+
+void HcSr04Array::setup() {}
+
+//!b Starts pinging from the first sensor.
+void HcSr04Array::begin() {
+	next = 0;
+	pingUs = ::micros();
+}
+
+//!b Returns sensor number (1 to n) whose ping ended, or 0.
+uint8_t HcSr04Array::loop() {
+	if(::micros() - pingUs < PING_SLOT) return 0;
+	pingUs = ::micros();
+	uint8_t i = next;
+	dists[i] = Host::hardware->sonar(trigPins[i]);
+	next = (next + 1) % n;
+	return i + 1;
+}
+
+//!b Returns last range of sensor (1 to n) (m) (0 if no echo).
+float HcSr04Array::get(uint8_t i) {
+	return dists[i - 1];
+}
+
+uint8_t HcSr04Array::getEchoPinId(uint8_t i) {
+	return echoPins[i - 1];
+}
+
+void HcSr04Array::isr() {}
+
+//**************************************************************/
+// LED
+//**************************************************************/
+
+Led::Led(uint8_t) {}
+
+void Led::setup() {}
+
+void Led::on() {}
+
+void Led::off() {}
+
+//**************************************************************/
+// OPENLOOPSERVO
+//**************************************************************/
+
+OpenLoopServo::OpenLoopServo(uint8_t pin, int, int, float, float,
+	float velocityMax) :
+	pin(pin), velocityMax(velocityMax), velocity(velocityMax),
+	angle(0), target(0), lastUs(0) {}
+
+//!b Sets the starting angle (rad).
+void OpenLoopServo::setup(float a) {
+	angle = a;
+	target = a;
+	lastUs = ::micros();
+	Host::hardware->servoAngle(pin, angle);
+}
+
+void OpenLoopServo::setVelocity(float v) {
+	velocity = min(fabs(v), velocityMax);
+}
+
+void OpenLoopServo::setAngle(float a) {
+	target = a;
+}
+
+//!b Moves the estimate toward the target and returns it (rad).
+float OpenLoopServo::loop() {
+	uint32_t now = ::micros();
+	float step = velocity * (now - lastUs) * 1e-6;
+	lastUs = now;
+	if(fabs(target - angle) <= step) angle = target;
+	else angle += (target > angle) ? step : -step;
+	Host::hardware->servoAngle(pin, angle);
+	return angle;
+}
+
+bool OpenLoopServo::atTargetAngle() {
+	return angle == target;
+}
+
+//!b Holds the current angle.
+void OpenLoopServo::stop() {
+	target = angle;
+}
+
+//**************************************************************/
+// PINCHANGEINT
+//**************************************************************/
+
+//!b Pin change interrupts never fire on the host.
+void attachPinChangeInterrupt(uint8_t, void (*)(), int) {}
@@ -0,0 +1,32 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t OpenLoopServo.h
+//!b Host shim of the OpenLoopServo library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class OpenLoopServo {
+public:
+	OpenLoopServo(uint8_t, int, int, float, float, float);
+	void setup(float);
+	void setVelocity(float);
+	void setAngle(float);
+	float loop();
+	bool atTargetAngle();
+	void stop();
+private:
+	uint8_t pin;
+	float velocityMax;	// (rad/s)
+	float velocity;		// (rad/s)
+	float angle;		// Estimate (rad)
+	float target;		// (rad)
+	uint32_t lastUs;
+};
@@ -0,0 +1,16 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t PinChangeInt.h
+//!b Host shim of the PinChangeInt library (see Libraries.cpp).
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// FUNCTION DECLARATIONS
+//**************************************************************/
+
+void attachPinChangeInterrupt(uint8_t, void (*)(), int);
@@ -0,0 +1,40 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Memory.cpp
+//!b Host stand-in for the Memory namespace.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d The robot's Memory.cpp paints and scans AVR SRAM with
+//!d assembly and linker symbols, which a PC does not have. The
+//!d host tools build this file in its place, which reports no
+//!d SRAM use.
+
+#include "Memory.h"
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+void Memory::setup() {}
+
+void Memory::loop() {}
+
+void Memory::scan() {}
+
+uint16_t Memory::staticBytes() {
+	return 0;
+}
+
+uint16_t Memory::heapBytes() {
+	return 0;
+}
+
+uint16_t Memory::stackBytes() {
+	return 0;
+}
+
+uint16_t Memory::marginBytes() {
+	return 0;
+}
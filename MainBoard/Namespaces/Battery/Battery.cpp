@@ -0,0 +1,76 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Battery.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Battery.h"
+#include "LoopTimer.h"
+#include "Capture.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Battery {
+
+	// Arduino Pin Settings
+	const uint8_t PIN_BATTERY = A1;
+
+	// Voltage Sensing
+	const float ADC_VOLTS = 5.0 / 1023.0;	// (V/ADC)
+	const float DIVIDER_RATIO = 3.0;		// Pack / pin voltage
+	const float SAMPLE_TIME = 0.1;			// (s)
+	const float FILTER_GAIN = 0.1;			// Low-pass gain
+
+	// Compensation Limits
+	const float NOMINAL_VOLTAGE = 12.0;	// Motor terminal voltage (V)
+	const float MIN_VALID_VOLTAGE = 6.0;	// Below this assume no pack (V)
+	const float COMPENSATION_MAX = 1.5;
+
+	// Filtered Battery Voltage
+	float voltage = NOMINAL_VOLTAGE;	// (V)
+	LoopTimer timer;
+
+	// Private Function Templates
+	float read();
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Initializes battery pin and filter.
+//!d Call this method in the main setup function.
+void Battery::setup() {
+	pinMode(PIN_BATTERY, INPUT);
+	voltage = read();
+	timer.tic();
+}
+
+//!b Samples and filters battery voltage at the sample rate.
+//!d Call this method in the main loop function.
+void Battery::loop() {
+	if(timer.hasElapsed(SAMPLE_TIME)) {
+		timer.tic();
+		voltage += FILTER_GAIN * (read() - voltage);
+	}
+}
+
+//!b Returns factor to scale motor voltage commands by.
+//!d Commands are computed against the nominal terminal voltage,
+//!d so they are scaled up by nominal / measured voltage. Returns
+//!d 1 if no pack is detected (e.g. running from USB).
+float Battery::compensation() {
+	if(voltage < MIN_VALID_VOLTAGE) {
+		return 1.0;
+	}
+	float k = NOMINAL_VOLTAGE / voltage;
+	return (k < COMPENSATION_MAX) ? k : COMPENSATION_MAX;
+}
+
+//!b Reads battery voltage (V) from ADC.
+float Battery::read() {
+	return Capture::analog(PIN_BATTERY) * ADC_VOLTS * DIVIDER_RATIO;
+}
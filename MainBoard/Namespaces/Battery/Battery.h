@@ -0,0 +1,28 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Battery.h
+//!b Namespace for final project battery voltage monitor.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This namespace samples the drive battery voltage through a
+//!d resistor divider at a low rate and low-pass filters it. The
+//!d drive system uses the filtered voltage to rescale motor
+//!d voltage commands, which assume a full pack, as the battery
+//!d sags during a mission.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Battery {
+	extern float voltage;
+
+	void setup();
+	void loop();
+	float compensation();
+}
@@ -0,0 +1,310 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Capture.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Capture.h"
+#if CAPTURE_REPLAY
+#include <avr/wdt.h>
+#endif
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Capture {
+
+	// Loop Start Time
+	volatile uint32_t nowUs = 0;
+	volatile uint32_t nowMs = 0;
+	uint16_t usRemainder = 0;
+
+#if CAPTURE_ENABLED
+	// Capture Port Settings
+	HardwareSerial*
+		PORT = &Serial2;
+	const unsigned long
+		BAUD = 500000;
+
+	// Loop Counter
+	uint32_t loopIndex = 0;
+
+#if CAPTURE_REPLAY
+	// Replay Chunk
+	const uint16_t CHUNK_MAX = 256;
+	uint8_t chunk[CHUNK_MAX];
+	uint16_t chunkLen = 0;
+	uint16_t chunkPos = 0;
+	bool diverged = false;
+#endif
+
+	// Private Function Templates
+	void write(const void*, uint8_t);
+	void writeRecord(record_t, const void*, uint8_t);
+#if CAPTURE_REPLAY
+	uint8_t readPort();
+	bool take(record_t, void*, uint8_t);
+#endif
+#endif
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Latches loop start time.
+//!i Time from micros (us)
+//!d Milliseconds are accumulated separately so they do not
+//!d wrap with micros after 71 minutes.
+void Capture::latch(uint32_t t) {
+	uint32_t dt = (t - nowUs) + usRemainder;
+	uint8_t sreg = SREG;
+	cli();
+	nowUs = t;
+	nowMs += dt / 1000;
+	SREG = sreg;
+	usRemainder = dt % 1000;
+}
+
+#if CAPTURE_ENABLED
+
+//!b Opens capture port.
+//!d Call this method first in the main setup function. Inputs
+//!d read during setup are captured as the first loop.
+void Capture::setup() {
+	PORT->begin(BAUD);
+	loop();
+}
+
+#if CAPTURE_REPLAY
+
+//!b Loads the records of the next loop from the replay host.
+//!d Call this method first in the main loop function. Latches
+//!d the recorded loop time. Idles (feeding the watchdog) once
+//!d the capture is exhausted or replay has diverged.
+void Capture::loop() {
+	if(chunkPos != chunkLen) diverged = true;
+	PORT->write(diverged ? REPLAY_DIVERGED : REPLAY_NEXT);
+	chunkLen = readPort();
+	chunkLen |= (uint16_t)readPort() << 8;
+	if(chunkLen == 0 || chunkLen > CHUNK_MAX) {
+		while(true) wdt_reset();
+	}
+	for(uint16_t i = 0; i < chunkLen; i++) {
+		chunk[i] = readPort();
+	}
+	chunkPos = 0;
+	uint32_t payload[2];
+	if(take(RECORD_LOOP, payload, sizeof(payload))) {
+		loopIndex = payload[0];
+		latch(payload[1]);
+	}
+}
+
+//!b Returns recorded IMU heading (rad).
+float Capture::imu(float h) {
+	take(RECORD_IMU, &h, sizeof(h));
+	return h;
+}
+
+//!b Replaces left and right encoder angles with recorded (rad).
+void Capture::encoders(float& dL, float& dR) {
+	float payload[2] = {dL, dR};
+	if(take(RECORD_ENCODERS, payload, sizeof(payload))) {
+		dL = payload[0];
+		dR = payload[1];
+	}
+}
+
+//!b Returns the array sensor with a recorded reading next (0 if
+//!b none).
+//!d The sensor that finishes depends on echo timing inside the
+//!d library, so it is taken from the SONAR record that follows.
+uint8_t Capture::sonarReady(uint8_t) {
+	if(diverged || chunkPos + 2 > chunkLen ||
+		chunk[chunkPos] != RECORD_SONAR) return 0;
+	uint8_t id = chunk[chunkPos + 1];
+	return (id >= 1 && id <= 4) ? id : 0;
+}
+
+//!b Returns recorded raw sonar distance (m).
+//!i Sensor number (1-4 for array, 5 for front ping)
+//!i Distance (m)
+float Capture::sonar(uint8_t sensor, float d) {
+	uint8_t payload[5];
+	if(take(RECORD_SONAR, payload, sizeof(payload))) {
+		if(payload[0] != sensor) diverged = true;
+		uint8_t* bytes = (uint8_t*)&d;
+		for(uint8_t i = 0; i < 4; i++) bytes[i] = payload[i + 1];
+	}
+	return d;
+}
+
+//!b Returns recorded analog pin value (ADC).
+int Capture::analog(uint8_t pin) {
+	uint8_t payload[3] = {pin, 0, 0};
+	take(RECORD_ANALOG, payload, sizeof(payload));
+	if(payload[0] != pin) diverged = true;
+	return payload[1] | (payload[2] << 8);
+}
+
+//!b Returns recorded number of serial bytes available.
+int Capture::available(int n) {
+	uint8_t count = 0;
+	take(RECORD_SERIAL_AVAILABLE, &count, 1);
+	return count;
+}
+
+//!b Returns recorded byte read from serial.
+byte Capture::serialByte(byte b) {
+	take(RECORD_SERIAL_BYTE, &b, 1);
+	return b;
+}
+
+//!b Returns recorded float read from serial.
+float Capture::serialFloat(float f) {
+	take(RECORD_SERIAL_FLOAT, &f, sizeof(f));
+	return f;
+}
+
+//!b Replaces servo angle estimate and target flag with recorded.
+//!i Servo number (1 pan, 2 tilt)
+//!i Angle (rad)
+//!i At target angle
+void Capture::servo(uint8_t id, float& angle, bool& atTarget) {
+	uint8_t payload[6];
+	if(take(RECORD_SERVO, payload, sizeof(payload))) {
+		if(payload[0] != id) diverged = true;
+		uint8_t* bytes = (uint8_t*)&angle;
+		for(uint8_t i = 0; i < 4; i++) bytes[i] = payload[i + 1];
+		atTarget = payload[5];
+	}
+}
+
+//!b Waits for and returns one byte from the replay host.
+uint8_t Capture::readPort() {
+	while(!PORT->available()) wdt_reset();
+	return PORT->read();
+}
+
+//!b Takes the next record of the loop chunk.
+//!d Sets the diverged flag and returns false if the next
+//!d record is not of the given type.
+//!i Record type
+//!i Payload destination
+//!i Payload size (bytes)
+bool Capture::take(record_t type, void* data, uint8_t n) {
+	if(diverged ||
+		chunkPos + 1 + n > chunkLen ||
+		chunk[chunkPos] != type) {
+		diverged = true;
+		return false;
+	}
+	uint8_t* bytes = (uint8_t*)data;
+	for(uint8_t i = 0; i < n; i++) {
+		bytes[i] = chunk[chunkPos + 1 + i];
+	}
+	chunkPos += 1 + n;
+	return true;
+}
+
+#else
+
+//!b Starts records for a new loop iteration.
+//!d Call this method first in the main loop function. Latches
+//!d loop time.
+void Capture::loop() {
+	latch(::micros());
+	uint32_t payload[2] = {loopIndex++, micros()};
+	PORT->write(0xA5);
+	PORT->write(0x5A);
+	writeRecord(RECORD_LOOP, payload, sizeof(payload));
+}
+
+//!b Records and returns IMU heading (rad).
+float Capture::imu(float h) {
+	writeRecord(RECORD_IMU, &h, sizeof(h));
+	return h;
+}
+
+//!b Records left and right encoder angles (rad).
+void Capture::encoders(float& dL, float& dR) {
+	float payload[2] = {dL, dR};
+	writeRecord(RECORD_ENCODERS, payload, sizeof(payload));
+}
+
+//!b Returns the array sensor with a new reading (0 if none).
+//!d Not recorded itself, as the SONAR record of the reading
+//!d marks it.
+uint8_t Capture::sonarReady(uint8_t id) {
+	return id;
+}
+
+//!b Records and returns a raw sonar distance (m).
+//!i Sensor number (1-4 for array, 5 for front ping)
+//!i Distance (m)
+float Capture::sonar(uint8_t sensor, float d) {
+	PORT->write(RECORD_SONAR);
+	PORT->write(sensor);
+	write(&d, sizeof(d));
+	return d;
+}
+
+//!b Reads, records, and returns an analog pin (ADC).
+int Capture::analog(uint8_t pin) {
+	uint16_t value = analogRead(pin);
+	PORT->write(RECORD_ANALOG);
+	PORT->write(pin);
+	write(&value, sizeof(value));
+	return value;
+}
+
+//!b Records and returns number of serial bytes available.
+int Capture::available(int n) {
+	uint8_t count = (n > 255) ? 255 : n;
+	writeRecord(RECORD_SERIAL_AVAILABLE, &count, 1);
+	return n;
+}
+
+//!b Records and returns a byte read from serial.
+byte Capture::serialByte(byte b) {
+	writeRecord(RECORD_SERIAL_BYTE, &b, 1);
+	return b;
+}
+
+//!b Records and returns a float read from serial.
+float Capture::serialFloat(float f) {
+	writeRecord(RECORD_SERIAL_FLOAT, &f, sizeof(f));
+	return f;
+}
+
+//!b Records servo angle estimate and target flag.
+//!i Servo number (1 pan, 2 tilt)
+//!i Angle (rad)
+//!i At target angle
+void Capture::servo(uint8_t id, float& angle, bool& atTarget) {
+	PORT->write(RECORD_SERVO);
+	PORT->write(id);
+	write(&angle, sizeof(angle));
+	PORT->write(atTarget ? 1 : 0);
+}
+
+#endif
+
+//!b Writes raw bytes to capture port.
+void Capture::write(const void* data, uint8_t n) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	for(uint8_t i = 0; i < n; i++) {
+		PORT->write(bytes[i]);
+	}
+}
+
+//!b Writes record type byte and payload to capture port.
+void Capture::writeRecord(record_t type, const void* data, uint8_t n) {
+	PORT->write((uint8_t)type);
+	write(data, n);
+}
+
+#endif
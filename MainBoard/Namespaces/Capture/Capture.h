@@ -0,0 +1,131 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Capture.h
+//!b Namespace for final project raw input capture.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Every raw input read by the namespaces passes through one
+//!d of the hooks below. With CAPTURE_ENABLED set to 1, each
+//!d hook writes a binary record of the value to the capture
+//!d port (to an SD serial logger) so a field run can be replayed
+//!d deterministically. With it set to 0 the hooks are inline
+//!d pass-throughs and compile out entirely.
+//!d
+//!d Capture format: each loop starts with the sync bytes 0xA5
+//!d 0x5A and a LOOP record, and is followed by records for every
+//!d input read during that loop. Each record is a type byte and
+//!d a little-endian payload:
+//!d - LOOP:             uint32 loop index, uint32 micros
+//!d - IMU:              float heading (rad)
+//!d - ENCODERS:         float left, float right (rad)
+//!d - SONAR:            uint8 sensor (1-4 array, 5 ping), float (m)
+//!d                     (an array record also marks which sensor
+//!d                     finished that loop)
+//!d - ANALOG:           uint8 pin, uint16 value (ADC)
+//!d - SERIAL_AVAILABLE: uint8 bytes available
+//!d - SERIAL_BYTE:      uint8 byte read
+//!d - SERIAL_FLOAT:     float read
+//!d - SERVO:            uint8 servo (1 pan, 2 tilt), float angle
+//!d                     (rad), uint8 at target
+//!d
+//!d Time is an input too: every namespace reads the clock through
+//!d micros() and millis() below (or a LoopTimer), which return
+//!d the time latched at the start of the loop, so the LOOP record
+//!d captures all of it.
+//!d
+//!d Replay: with CAPTURE_REPLAY also set to 1, the hooks return
+//!d the recorded values in place of the hardware reads. Before
+//!d each loop the robot sends REPLAY_NEXT (or REPLAY_DIVERGED if a
+//!d hook asked for a record the capture did not have next) on the
+//!d capture port, and ReplayCapture.m answers with a uint16 chunk
+//!d length and the records of the next loop (length 0 once the
+//!d capture is exhausted). Host/FireBotReplay does the same for a
+//!d replay build on a PC.
+
+#pragma once
+#include "Arduino.h"
+
+// Set to 1 to stream raw inputs on the capture port
+#ifndef CAPTURE_ENABLED
+#define CAPTURE_ENABLED 0
+#endif
+
+// Set to 1 (with CAPTURE_ENABLED) to replay a capture instead
+#ifndef CAPTURE_REPLAY
+#define CAPTURE_REPLAY 0
+#endif
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Capture {
+	enum record_t {
+		RECORD_LOOP = 0x01,
+		RECORD_IMU = 0x02,
+		RECORD_ENCODERS = 0x03,
+		RECORD_SONAR = 0x04,
+		RECORD_ANALOG = 0x05,
+		RECORD_SERIAL_AVAILABLE = 0x06,
+		RECORD_SERIAL_BYTE = 0x07,
+		RECORD_SERIAL_FLOAT = 0x08,
+		RECORD_SERVO = 0x09,
+	};
+
+	// Replay Request Bytes
+	const byte REPLAY_NEXT = 0x4E;
+	const byte REPLAY_DIVERGED = 0x44;
+
+	// Loop Start Time
+	extern volatile uint32_t nowUs;
+	extern volatile uint32_t nowMs;
+
+	// Latches loop start time
+	void latch(uint32_t);
+
+	//!b Returns time at start of loop (us).
+	inline uint32_t micros() {
+		uint8_t sreg = SREG;
+		cli();
+		uint32_t t = nowUs;
+		SREG = sreg;
+		return t;
+	}
+
+	//!b Returns time at start of loop (ms).
+	inline uint32_t millis() {
+		uint8_t sreg = SREG;
+		cli();
+		uint32_t t = nowMs;
+		SREG = sreg;
+		return t;
+	}
+
+#if CAPTURE_ENABLED
+	void setup();
+	void loop();
+	float imu(float);
+	void encoders(float&, float&);
+	uint8_t sonarReady(uint8_t);
+	float sonar(uint8_t, float);
+	int analog(uint8_t);
+	int available(int);
+	byte serialByte(byte);
+	float serialFloat(float);
+	void servo(uint8_t, float&, bool&);
+#else
+	inline void setup() { latch(::micros()); }
+	inline void loop() { latch(::micros()); }
+	inline float imu(float h) { return h; }
+	inline void encoders(float&, float&) {}
+	inline uint8_t sonarReady(uint8_t id) { return id; }
+	inline float sonar(uint8_t, float d) { return d; }
+	inline int analog(uint8_t pin) { return analogRead(pin); }
+	inline int available(int n) { return n; }
+	inline byte serialByte(byte b) { return b; }
+	inline float serialFloat(float f) { return f; }
+	inline void servo(uint8_t, float&, bool&) {}
+#endif
+}
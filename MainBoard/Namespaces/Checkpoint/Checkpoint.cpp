@@ -0,0 +1,204 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Checkpoint.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Checkpoint.h"
+#include <avr/wdt.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Checkpoint {
+
+	// Watchdog Timeout
+	// Longer than the Matlab message timeout.
+	const uint8_t WATCHDOG_TIMEOUT = WDTO_2S;
+
+	// EEPROM Slot Ring
+	const uint16_t SLOT_BASE = 0;		// (byte address)
+	const uint16_t SLOT_SIZE = sizeof(Record);	// (bytes)
+	const uint8_t NUM_SLOTS = 16;
+
+	// Working record and reset-surviving copy
+	Record record;
+	Record ramCopy __attribute__((section(".noinit")));
+
+	// Reset cause (MCUSR) saved before it is cleared (0 if the
+	// bootloader cleared it first)
+	uint8_t mcusr __attribute__((section(".noinit")));
+
+	// Run marker (set while a mission may be resumed)
+	constexpr uint32_t hash(const char* s, uint32_t h = 2166136261UL) {
+		return *s ? hash(s + 1, (h ^ (uint8_t)*s) * 16777619UL) : h;
+	}
+	const uint32_t RUN_MARKER = hash(__DATE__ " " __TIME__);
+	uint32_t runMarker __attribute__((section(".noinit")));
+
+	// EEPROM Writer
+	Record eepromCopy;
+	uint8_t slot = 0;		// Slot being written
+	uint8_t written = sizeof(Record);	// Bytes of copy written
+	uint16_t sequence = 0;	// Sequence of last record
+
+	// Private Function Templates
+	void saveResetCause() __attribute__((naked, used, section(".init3")));
+	uint16_t crc(const Record&);
+	bool valid(const Record&);
+	bool newer(const Record&, const Record&);
+	uint8_t* slotAddress(uint8_t);
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Saves and clears reset cause and disables the watchdog.
+//!d Runs from the .init3 section, as a watchdog reset leaves the
+//!d watchdog running. Do not call this method.
+void Checkpoint::saveResetCause() {
+	mcusr = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+//!b Finds newest checkpoint and selects the next EEPROM slot.
+//!d Call this method in the main setup function. Returns true
+//!d and loads 'record' if the robot was reset mid-mission (run
+//!d marker set, or a brown-out flag) and a valid checkpoint
+//!d exists. EEPROM checkpoints, which may be left from an earlier
+//!d run, are only used after a brown-out that cleared the RAM
+//!d copy. Otherwise the RAM copy is discarded, so only this run's
+//!d checkpoints can be resumed later.
+bool Checkpoint::setup() {
+
+	// Find newest valid EEPROM record
+	Record newest;
+	bool found = false;
+	for(uint8_t i = 0; i < NUM_SLOTS; i++) {
+		Record r;
+		eeprom_read_block(&r, slotAddress(i), sizeof(Record));
+		if(valid(r) && (!found || newer(r, newest))) {
+			newest = r;
+			slot = i;
+			found = true;
+		}
+	}
+	if(found) {
+		sequence = newest.sequence;
+		slot = (slot + 1) % NUM_SLOTS;
+	}
+
+	// Only resume after an unplanned reset. BORF can be set
+	// along with PORF at power-on, so PORF rules it out.
+	bool powerOn = mcusr & _BV(PORF);
+	bool brownOut = (mcusr & _BV(BORF)) && !powerOn;
+	bool unplanned = !powerOn &&
+		(runMarker == RUN_MARKER || brownOut);
+
+	// Use RAM copy if valid, as it is saved with every checkpoint.
+	// A watchdog reset always keeps it, so without a valid RAM
+	// copy only a brown-out (which may clear RAM) falls back to
+	// EEPROM.
+	if(unplanned && valid(ramCopy)) {
+		if(!found || newer(ramCopy, newest)) {
+			sequence = ramCopy.sequence;
+		}
+		newest = ramCopy;
+		found = true;
+	} else if(!brownOut) {
+		found = false;
+	}
+
+	bool resume = found && unplanned &&
+		newest.fireBotState != 0;
+	if(resume) {
+		record = newest;
+		record.resumes++;
+	} else {
+		ramCopy.crc = ~crc(ramCopy);
+	}
+	return resume;
+}
+
+//!b Enables the watchdog and sets the run marker.
+//!d Call this method last in the main setup function, and again
+//!d when a mission carries on after finish().
+void Checkpoint::start() {
+	runMarker = RUN_MARKER;
+	wdt_enable(WATCHDOG_TIMEOUT);
+}
+
+//!b Clears the run marker so a reset starts a new mission.
+//!d Call this method when the mission ends or faults.
+void Checkpoint::finish() {
+	runMarker = 0;
+}
+
+//!b Disables the watchdog.
+//!d Call this method before any intentional infinite loop.
+void Checkpoint::stop() {
+	wdt_disable();
+}
+
+//!b Resets the watchdog and continues any EEPROM copy.
+//!d Call this method in the main loop function.
+void Checkpoint::loop() {
+	wdt_reset();
+	if(written < sizeof(Record) && eeprom_is_ready()) {
+		eeprom_write_byte(
+			slotAddress(slot) + written,
+			((uint8_t*)&eepromCopy)[written]);
+		if(++written == sizeof(Record)) {
+			slot = (slot + 1) % NUM_SLOTS;
+		}
+	}
+}
+
+//!b Commits 'record' as the newest checkpoint.
+//!i Also copy to EEPROM (ignored if a copy is in progress)
+void Checkpoint::save(bool toEeprom) {
+	record.sequence = ++sequence;
+	record.crc = crc(record);
+	ramCopy = record;
+	if(toEeprom && written == sizeof(Record)) {
+		eepromCopy = record;
+		written = 0;
+	}
+}
+
+//!b Returns MCUSR reset flags from the last reset.
+uint8_t Checkpoint::resetCause() {
+	return mcusr;
+}
+
+//!b Returns CRC-16 of a record (excluding the CRC field).
+uint16_t Checkpoint::crc(const Record& r) {
+	const uint8_t* p = (const uint8_t*)&r;
+	uint16_t c = 0xFFFF;
+	for(uint8_t i = 0; i < sizeof(Record) - sizeof(r.crc); i++) {
+		c = _crc16_update(c, p[i]);
+	}
+	return c;
+}
+
+//!b Returns true if a record's CRC matches.
+bool Checkpoint::valid(const Record& r) {
+	return r.crc == crc(r);
+}
+
+//!b Returns true if record a is newer than record b.
+//!d Sequence numbers are compared modulo 2^16.
+bool Checkpoint::newer(const Record& a, const Record& b) {
+	return (int16_t)(a.sequence - b.sequence) > 0;
+}
+
+//!b Returns EEPROM address of a slot.
+uint8_t* Checkpoint::slotAddress(uint8_t i) {
+	return (uint8_t*)(uintptr_t)(SLOT_BASE + i * SLOT_SIZE);
+}
@@ -0,0 +1,71 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Checkpoint.h
+//!b Namespace for final project watchdog and mission checkpoints.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d The AVR watchdog resets the robot if the main loop hangs.
+//!d The mission is checkpointed so that after a watchdog or
+//!d brown-out reset it resumes instead of starting over. The
+//!d owner fills in 'record' and calls save(). Each checkpoint is
+//!d kept in .noinit RAM, which survives a watchdog reset. Some
+//!d are also copied to EEPROM (which survives a brown-out), one
+//!d byte per loop so the loop never waits on an EEPROM write.
+//!d EEPROM copies rotate through a ring of slots to spread wear.
+//!d Every copy carries a sequence number and a CRC-16, and only
+//!d the newest copy with a valid CRC is restored.
+//!d
+//!d The stock Mega bootloader clears MCUSR before the sketch
+//!d runs, so resets are told apart by a run marker in .noinit
+//!d RAM instead. start() sets it and finish() clears it when the
+//!d mission ends or faults, so a reset with the marker set was
+//!d unplanned. The marker holds a hash of the build time, so it
+//!d is random after power-on and stale after an upload. Pressing
+//!d reset mid-mission resumes too; power-cycle to start over.
+//!d Reset flags are still used when a bootloader keeps them:
+//!d PORF rules resuming out, and BORF allows the EEPROM copy
+//!d after a brown-out that cleared RAM.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Checkpoint {
+	struct Record {
+		uint16_t sequence;
+		uint8_t fireBotState;
+		uint8_t wallState;
+		uint8_t wallPausedState;
+		uint8_t wallDirection;
+		float x;				// (m)
+		float y;				// (m)
+		float distance;			// (m)
+		float heading;			// (rad)
+		float flameHeading;		// (rad)
+		float flameTilt;		// (rad)
+		float candleDriveStart;	// (m)
+		float candleDriveDist;	// (m)
+		float flamePos[3];		// (m)
+		float missionTime;		// (s)
+		float eventTimes[3];	// (s)
+		uint8_t faultCode;
+		uint8_t resumes;
+		uint16_t homeSignature[4];	// (mm)
+		uint16_t crc;
+	};
+
+	extern Record record;
+
+	bool setup();
+	void start();
+	void finish();
+	void stop();
+	void loop();
+	void save(bool);
+	uint8_t resetCause();
+}
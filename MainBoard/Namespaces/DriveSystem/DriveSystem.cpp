@@ -9,6 +9,8 @@
 #include "MotorL.h"
 #include "MotorR.h"
 #include "Odometer.h"
+#include "Battery.h"
+#include "LoopTimer.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -17,31 +19,100 @@
 namespace DriveSystem {
 
 	// Drive System Parameters
+	const float WHEEL_VOLTS_MAX = 12.0;	// (V)
 	const float DRIVE_VOLTS_MAX = 9.0;	// (V)
-	const float TURN_VOLTS_MAX = 3.0;	// (V)
+	const float TURN_SPEED_MAX = 0.15;	// (m/s)
 	const float PID_RESET_TIME = 0.2;	// (s)
 
-	// Velocity PID controller
-	// Input: Velocity (m/s)
-	// Output: Motor drive voltage (V)
-	const float V_KP = 0.0;
+	// Wheel Motor Feedforward Model
+	// V = KV * v + KS * sign(v)
+	const float WHEEL_KV = 20.0;	// (V*s/m)
+	const float WHEEL_KS = 1.0;		// Friction offset (V)
+	const float WHEEL_DEADBAND = 0.005;	// (m/s)
+
+	// Wheel Velocity PID Controllers
+	// Input: Wheel velocity (m/s)
+	// Output: Motor voltage correction (V)
+	const float V_KP = 10.0;
 	const float V_KI = 40.0;
 	const float V_KD = 0.0;
-	PidController velPid(V_KP, V_KI, V_KD,
+	FixedPid<12> wheelPidL(V_KP, V_KI, V_KD,
+		-DRIVE_VOLTS_MAX,
+		+DRIVE_VOLTS_MAX,
+		PID_RESET_TIME);
+	FixedPid<12> wheelPidR(V_KP, V_KI, V_KD,
 		-DRIVE_VOLTS_MAX,
 		+DRIVE_VOLTS_MAX,
 		PID_RESET_TIME);
 
 	// Heading PID Controller
 	// Input: Angle (rad)
-	// Output: Differential drive voltage (V)
-	const float H_KP = 40.0;
-	const float H_KI = 0.1;
-	const float H_KD = 5.0;
-	PidController headingPid(H_KP, H_KI, H_KD,
-		-TURN_VOLTS_MAX,
-		+TURN_VOLTS_MAX,
+	// Output: Differential wheel velocity (m/s)
+	// Gains are scheduled between pivot turns and small
+	// corrections while driving at speed.
+	const float H_KP_PIVOT = 2.0;
+	const float H_KI_PIVOT = 0.005;
+	const float H_KD_PIVOT = 0.25;
+	const float H_KP_TRACK = 1.2;
+	const float H_KI_TRACK = 0.02;
+	const float H_KD_TRACK = 0.08;
+	FixedPid<12> headingPid(H_KP_PIVOT, H_KI_PIVOT, H_KD_PIVOT,
+		-TURN_SPEED_MAX,
+		+TURN_SPEED_MAX,
 		PID_RESET_TIME);
+
+	// Scheduled Heading Gains (kp, ki, kd)
+	float pivotGains[3] = {H_KP_PIVOT, H_KI_PIVOT, H_KD_PIVOT};
+	float trackGains[3] = {H_KP_TRACK, H_KI_TRACK, H_KD_TRACK};
+
+	// Heading Gain Schedule
+	const float TRACK_ERROR_MAX = 0.25;	// Enter track below (rad)
+	const float PIVOT_ERROR_MIN = 0.35;	// Enter pivot above (rad)
+	const float TRACK_SPEED_MIN = 0.03;	// (m/s)
+	enum {
+		SCHEDULE_PIVOT,
+		SCHEDULE_TRACK,
+	} schedule = SCHEDULE_PIVOT;
+
+	// Turn Profile Limits
+	const float TURN_VEL_MAX = 1.2;		// (rad/s)
+	const float TURN_ACC_MAX = 5.0;		// (rad/s^2)
+	const float TURN_JERK_MAX = 40.0;	// (rad/s^3)
+	const float TURN_RETARGET = 0.02;	// Target change to restart (rad)
+
+	// Straight Profile Limits
+	const float LINE_VEL_MAX = 0.3;		// (m/s)
+	const float LINE_ACC_MAX = 0.5;		// (m/s^2)
+	const float LINE_JERK_MAX = 4.0;	// (m/s^3)
+	const float LINE_TOLERANCE = 0.01;	// (m)
+
+	// Profile Feedforward Gains
+	const float H_KV = 0.1;		// Turn rate to diff speed (m/rad)
+	const float H_KA = 0.0;		// Turn accel to diff speed (m*s/rad)
+	const float D_KP = 2.0;		// Distance error to velocity (1/s)
+
+	// Motion Profile State
+	struct Profile {
+		float pos;	// Setpoint position
+		float vel;	// Setpoint velocity
+		float acc;	// Setpoint acceleration
+		float goal;	// Final position
+		bool active;
+	};
+	Profile turnProfile = {0, 0, 0, 0, false};
+	Profile lineProfile = {0, 0, 0, 0, false};
+	float turnTarget = 0;	// (rad)
+	float lineTarget = 0;	// (m)
+	LoopTimer profileTimer;
+
+	// Private Function Templates
+	float headingError(float, float);
+	bool track(float, float);
+	void driveWheels(float, float);
+	float feedforward(float);
+	void scheduleGains(float, float);
+	void startProfile(Profile&, float, float);
+	bool stepProfile(Profile&, float, float, float, float);
 }
 
 //**************************************************************/
@@ -53,12 +124,139 @@ namespace DriveSystem {
 void DriveSystem::setup() {
 	MotorL::setup();
 	MotorR::setup();
+	wheelPidL.setTraceId(Trace::PID_WHEEL_L);
+	wheelPidR.setTraceId(Trace::PID_WHEEL_R);
+	headingPid.setTraceId(Trace::PID_HEADING);
 }
 
 //!b Drives robot at given heading and velocity via PID control.
 //!i Target heading (rad)
 //!i Target velocity (m/s) (default 0)
 bool DriveSystem::drive(float ht, float vt) {
+	turnProfile.active = false;
+	lineProfile.active = false;
+	return track(ht, vt);
+}
+
+//!b Turns robot in place to given heading along a jerk-limited
+//!b motion profile.
+//!i Target heading (rad)
+//!d Profile setpoints are tracked with the heading PID plus a
+//!d rate and acceleration feedforward. Returns true once the
+//!d profile is complete and the heading is at steady state.
+bool DriveSystem::turn(float ht) {
+	float hc = Odometer::heading;
+
+	// Start new profile from current heading
+	if(!turnProfile.active ||
+		fabs(headingError(ht, turnTarget)) > TURN_RETARGET)
+	{
+		startProfile(turnProfile, hc, hc + headingError(ht, hc));
+		turnTarget = ht;
+		headingPid.reset();
+	}
+
+	// Advance heading setpoint
+	scheduleGains(PI, 0);
+	float dt = profileTimer.toc();
+	profileTimer.tic();
+	bool done = stepProfile(turnProfile,
+		TURN_VEL_MAX,
+		TURN_ACC_MAX,
+		TURN_JERK_MAX,
+		dt);
+
+	// Track setpoint with PID and feedforward
+	float vDiff =
+		headingPid.update(headingError(turnProfile.pos, hc)) +
+		H_KV * turnProfile.vel +
+		H_KA * turnProfile.acc;
+	vDiff = constrain(vDiff, -TURN_SPEED_MAX, +TURN_SPEED_MAX);
+	driveWheels(+vDiff, -vDiff);
+
+	return done && headingPid.steadyState(0.02, 0.002);
+}
+
+//!b Drives robot a given distance at given heading along a
+//!b jerk-limited motion profile.
+//!i Target heading (rad)
+//!i Distance to travel (m) (negative to reverse)
+//!d Returns true once the profile is complete and the robot is
+//!d within tolerance of the final distance.
+bool DriveSystem::driveDistance(float ht, float dist) {
+
+	// Start new profile from current distance
+	if(!lineProfile.active || dist != lineTarget) {
+		float d0 = Odometer::distance;
+		startProfile(lineProfile, d0, d0 + dist);
+		lineTarget = dist;
+	}
+
+	// Advance distance setpoint
+	float dt = profileTimer.toc();
+	profileTimer.tic();
+	bool done = stepProfile(lineProfile,
+		LINE_VEL_MAX,
+		LINE_ACC_MAX,
+		LINE_JERK_MAX,
+		dt);
+
+	// Track setpoint velocity with distance correction
+	float dError = lineProfile.pos - Odometer::distance;
+	track(ht, lineProfile.vel + D_KP * dError);
+
+	return done && fabs(lineProfile.goal - Odometer::distance)
+		<= LINE_TOLERANCE;
+}
+
+//!b Immediately stops drive motors and resets PID controllers.
+void DriveSystem::stop() {
+	MotorL::motor.brake();
+	MotorR::motor.brake();
+	headingPid.reset();
+	wheelPidL.reset();
+	wheelPidR.reset();
+	turnProfile.active = false;
+	lineProfile.active = false;
+}
+
+//!b Sets gains of a drive system controller at runtime.
+//!i Controller (see gains_t)
+//!i Proportional gain
+//!i Integral gain
+//!i Derivative gain
+//!d Returns false if the controller is not a drive system one.
+bool DriveSystem::setGains(uint8_t pid, float kp, float ki, float kd) {
+	switch(pid) {
+		case GAINS_WHEEL:
+			wheelPidL.setGains(kp, ki, kd);
+			wheelPidR.setGains(kp, ki, kd);
+			return true;
+		case GAINS_PIVOT:
+			pivotGains[0] = kp;
+			pivotGains[1] = ki;
+			pivotGains[2] = kd;
+			if(schedule == SCHEDULE_PIVOT) {
+				headingPid.setGains(kp, ki, kd);
+			}
+			return true;
+		case GAINS_TRACK:
+			trackGains[0] = kp;
+			trackGains[1] = ki;
+			trackGains[2] = kd;
+			if(schedule == SCHEDULE_TRACK) {
+				headingPid.setGains(kp, ki, kd);
+			}
+			return true;
+		default:
+			return false;
+	}
+}
+
+//!b Returns shortest angle (rad) from current to target heading.
+//!i Target heading (rad)
+//!i Current heading (rad)
+float DriveSystem::headingError(float ht, float hc) {
 
 	// Convert target heading into 0-2pi range
 	if(ht > TWO_PI) {
@@ -67,33 +265,140 @@ bool DriveSystem::drive(float ht, float vt) {
 		ht = fmod(ht, TWO_PI) + TWO_PI;
 	}
 
-	// Compute heading PID error
-	float hError;
-	float hc = Odometer::heading;
+	// Compute heading error
 	if(ht <= PI) {
-		if(hc <= ht + PI) hError = ht - hc;
-		else hError = ht + TWO_PI - hc;
+		if(hc <= ht + PI) return ht - hc;
+		else return ht + TWO_PI - hc;
 	} else {
-		if(hc <= ht - PI) hError = ht - TWO_PI - hc;
-		else hError = ht - hc;
+		if(hc <= ht - PI) return ht - TWO_PI - hc;
+		else return ht - hc;
 	}
+}
+
+//!b Runs heading PID loop and drives wheels at target speeds.
+//!i Target heading (rad)
+//!i Target velocity (m/s)
+//!d Returns true if robot is at heading steady state.
+bool DriveSystem::track(float ht, float vt) {
 
-	// Update PID controllers
+	// Update heading PID controller
+	float hError = headingError(ht, Odometer::heading);
+	scheduleGains(hError, vt);
 	float vDiff = headingPid.update(hError);
-	float vDrive = velPid.update(vt - Odometer::velocity);
 
-	// Drive motors
-	MotorL::motor.setVoltage(vDrive + vDiff);
-	MotorR::motor.setVoltage(vDrive - vDiff);
+	// Drive wheels
+	driveWheels(vt + vDiff, vt - vDiff);
 
 	// Check if robot is at heading steady state
 	return headingPid.steadyState(0.02, 0.002);
 }
 
-//!b Immediately stops drive motors and resets PID controllers.
-void DriveSystem::stop() {
-	MotorL::motor.brake();
-	MotorR::motor.brake();
-	headingPid.reset();
-	velPid.reset();
+//!b Selects heading PID gains for the current regime.
+//!i Heading error (rad)
+//!i Target velocity (m/s)
+//!d Pivot gains are used for large errors or when not driving,
+//!d and tracking gains for small errors at speed. The error
+//!d thresholds have hysteresis to avoid chattering between
+//!d schedules, and gain changes are bumpless.
+void DriveSystem::scheduleGains(float hError, float vt) {
+	bool moving = fabs(vt) >= TRACK_SPEED_MIN;
+	switch(schedule) {
+		case SCHEDULE_PIVOT:
+			if(moving && fabs(hError) < TRACK_ERROR_MAX) {
+				headingPid.setGains(
+					trackGains[0], trackGains[1], trackGains[2]);
+				schedule = SCHEDULE_TRACK;
+			}
+			break;
+		case SCHEDULE_TRACK:
+			if(!moving || fabs(hError) > PIVOT_ERROR_MIN) {
+				headingPid.setGains(
+					pivotGains[0], pivotGains[1], pivotGains[2]);
+				schedule = SCHEDULE_PIVOT;
+			}
+			break;
+	}
+}
+
+//!b Drives each wheel at a target velocity.
+//!i Left wheel velocity (m/s)
+//!i Right wheel velocity (m/s)
+//!d Each motor voltage is the feedforward model output plus a
+//!d PID correction on that wheel's encoder velocity, rescaled
+//!d for the measured battery voltage.
+void DriveSystem::driveWheels(float vL, float vR) {
+	float k = Battery::compensation();
+	float uL = k * (feedforward(vL) +
+		wheelPidL.update(vL - Odometer::velocityL));
+	float uR = k * (feedforward(vR) +
+		wheelPidR.update(vR - Odometer::velocityR));
+	MotorL::motor.setVoltage(
+		constrain(uL, -WHEEL_VOLTS_MAX, +WHEEL_VOLTS_MAX));
+	MotorR::motor.setVoltage(
+		constrain(uR, -WHEEL_VOLTS_MAX, +WHEEL_VOLTS_MAX));
+}
+
+//!b Returns feedforward motor voltage (V) for a wheel velocity.
+//!i Wheel velocity (m/s)
+float DriveSystem::feedforward(float v) {
+	if(v > WHEEL_DEADBAND) {
+		return WHEEL_KV * v + WHEEL_KS;
+	} else if(v < -WHEEL_DEADBAND) {
+		return WHEEL_KV * v - WHEEL_KS;
+	} else {
+		return WHEEL_KV * v;
+	}
+}
+
+//!b Starts a motion profile at rest.
+//!i Profile to start
+//!i Initial position
+//!i Goal position
+void DriveSystem::startProfile(Profile& p, float p0, float goal) {
+	p.pos = p0;
+	p.vel = 0;
+	p.acc = 0;
+	p.goal = goal;
+	p.active = true;
+	profileTimer.tic();
+}
+
+//!b Advances a motion profile by one time step.
+//!i Profile to advance
+//!i Velocity limit
+//!i Acceleration limit
+//!i Jerk limit
+//!i Time step (s)
+//!d Velocity is capped by the braking distance to the goal, with
+//!d the braking point moved up to allow for the jerk-limited
+//!d acceleration ramp. Returns true once the goal is reached.
+bool DriveSystem::stepProfile(Profile& p,
+	float vMax, float aMax, float jMax, float dt)
+{
+	float e = p.goal - p.pos;
+	if(e == 0) return true;
+	if(dt <= 0) return false;
+
+	// Velocity allowed by braking distance
+	float lead = fabs(p.vel) * aMax / (2.0 * jMax);
+	float room = fabs(e) - lead;
+	float vDes = (room > 0) ? sqrt(2.0 * aMax * room) : 0;
+	if(vDes > vMax) vDes = vMax;
+	if(e < 0) vDes = -vDes;
+
+	// Jerk-limited acceleration towards desired velocity
+	float aDes = constrain((vDes - p.vel) / dt, -aMax, +aMax);
+	float dA = jMax * dt;
+	p.acc = constrain(aDes, p.acc - dA, p.acc + dA);
+	p.vel += p.acc * dt;
+	p.pos += p.vel * dt;
+
+	// Finish once setpoint reaches or passes the goal
+	if((p.goal - p.pos) * e <= 0) {
+		p.pos = p.goal;
+		p.vel = 0;
+		p.acc = 0;
+		return true;
+	}
+	return false;
 }
@@ -9,16 +9,29 @@
 //!d This namespace controls the robot drive system via the
 //!d MotorL and MotorR namespaces. It initializes the drive
 //!d motors and PID controls robot heading and drive velocity.
+//!d Heading control sets the two wheel speeds, and each wheel
+//!d runs its own velocity loop with a static motor feedforward.
+//!d Turns and straight segments can also be run along jerk-
+//!d limited motion profiles with feedforward.
 
 #pragma once
-#include "PidController.h"
+#include "FixedPid.h"
 
 //**************************************************************/
 // NAMESPACE DECLARATION
 //**************************************************************/
 
 namespace DriveSystem {
+	enum gains_t {
+		GAINS_WHEEL = 1,
+		GAINS_PIVOT = 2,
+		GAINS_TRACK = 3,
+	};
+
 	void setup();
 	bool drive(float, float = 0);
+	bool turn(float);
+	bool driveDistance(float, float);
 	void stop();
+	bool setGains(uint8_t, float, float, float);
 }
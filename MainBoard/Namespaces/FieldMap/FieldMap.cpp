@@ -0,0 +1,244 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FieldMap.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "FieldMap.h"
+#include "Odometer.h"
+#include "Sonar.h"
+#include "PanTilt.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace FieldMap {
+
+	// Map Parameters
+	const float HALF_SIZE = SIZE * CELL / 2.0;	// (m)
+	const float RAY_STEP = CELL / 2.0;			// (m)
+	const float SONAR_RANGE = 1.5;		// Max mapped reading (m)
+	const float FLAME_RANGE = 1.0;		// Flame sweep range (m)
+	const float VACANT_RANGE = FLAME_RANGE;	// Max vacant mark (m)
+	const float FRONTIER_MIN = FLAME_RANGE;	// Nearer is swept here (m)
+
+	// Cell Bitsets (bit = j * SIZE + i)
+	const uint16_t BYTES = (SIZE * SIZE + 7) / 8;
+	uint8_t occupiedBits[BYTES];
+	uint8_t vacantBits[BYTES];
+	uint8_t sweptBits[BYTES];
+
+	// Sonar angles from heading (front, back, left, right) (rad)
+	const float SONAR_ANGLE[4] = { 0, PI, -HALF_PI, HALF_PI };
+	uint16_t lastCycle = 0;
+
+	// Frontier Search (one pass over the map every few loops)
+	const uint8_t SCAN_CELLS = 20;	// Max cells checked per loop
+	uint16_t scanCell = 0;			// Next cell (k = j * SIZE + i)
+	float scanBest = -1;			// Nearest frontier this pass (m)
+	Vec2 scanTarget;				// Nearest frontier this pass
+	bool frontierFound = false;		// Last pass found a frontier
+	Vec2 frontierTarget;			// Last pass nearest frontier
+
+	// Private Function Templates
+	bool getBit(const uint8_t*, uint8_t, uint8_t);
+	void setBit(uint8_t*, uint8_t, uint8_t, bool);
+	void sonarRay(float, float);
+	void scanFrontier();
+	bool isFrontier(const Vec2&);
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Clears all cells to unknown and unswept.
+//!d Call this method when the mission starts.
+void FieldMap::clear() {
+	for(uint16_t k = 0; k < BYTES; k++) {
+		occupiedBits[k] = 0;
+		vacantBits[k] = 0;
+		sweptBits[k] = 0;
+	}
+	lastCycle = Sonar::cycles;
+	scanCell = 0;
+	scanBest = -1;
+	frontierFound = false;
+}
+
+//!b Maps the four sonar readings once per sonar cycle.
+//!d Call this method every loop while the sonar is running. Also
+//!d advances the frontier search.
+void FieldMap::loop() {
+	scanFrontier();
+	if(Sonar::cycles == lastCycle) return;
+	lastCycle = Sonar::cycles;
+	sonarRay(SONAR_ANGLE[0], Sonar::distF);
+	sonarRay(SONAR_ANGLE[1], Sonar::distB);
+	sonarRay(SONAR_ANGLE[2], Sonar::distL);
+	sonarRay(SONAR_ANGLE[3], Sonar::distR);
+}
+
+//!b Marks cells along the flame sensor's line of sight as swept.
+//!d Call this method every loop while PanTilt is sweeping. The
+//!d ray stops at the first occupied cell.
+void FieldMap::sweep() {
+	float a = Odometer::heading + PanTilt::pan;
+	Vec2 step(RAY_STEP * sin(a), RAY_STEP * cos(a));
+	Vec2 p = Odometer::position;
+	uint8_t i, j;
+	for(float s = 0; s <= FLAME_RANGE; s += RAY_STEP) {
+		if(!cellOf(p, i, j) || occupied(i, j)) return;
+		setBit(sweptBits, i, j, true);
+		p += step;
+	}
+}
+
+//!b Marks cells vacant along a sonar ray and occupied at its end.
+//!i Sensor angle from heading (rad)
+//!i Distance reading (m) (0 if invalid)
+//!d Cells are only marked vacant within the flame sweep range,
+//!d and only by sensors inside the pan range (front and right),
+//!d which keeps every frontier within sweeping reach. The other
+//!d sensors still mark walls.
+void FieldMap::sonarRay(float angle, float dist) {
+	if(dist == 0) return;
+	bool sweepable = (angle >= PanTilt::PAN_MIN &&
+		angle <= PanTilt::PAN_MAX);
+	bool hit = (dist <= SONAR_RANGE);
+	if(!hit) dist = SONAR_RANGE;
+	float a = Odometer::heading + angle;
+	Vec2 dir(sin(a), cos(a));
+	Vec2 p = Odometer::position;
+	uint8_t i, j;
+	float vacantEnd = sweepable ? dist - RAY_STEP : 0;
+	if(vacantEnd > VACANT_RANGE) vacantEnd = VACANT_RANGE;
+	for(float s = 0; s < vacantEnd; s += RAY_STEP) {
+		if(cellOf(p + dir * s, i, j)) {
+			setBit(vacantBits, i, j, true);
+			setBit(occupiedBits, i, j, false);
+		}
+	}
+	if(hit && cellOf(p + dir * dist, i, j)) {
+		setBit(occupiedBits, i, j, true);
+		setBit(vacantBits, i, j, false);
+	}
+}
+
+//!b Finds the cell containing a position.
+//!i Position (x,y) (m)
+//!i Cell x index (output)
+//!i Cell y index (output)
+//!d Returns false if the position is outside the map.
+bool FieldMap::cellOf(const Vec2& p, uint8_t& i, uint8_t& j) {
+	float x = (p.x + HALF_SIZE) / CELL;
+	float y = (p.y + HALF_SIZE) / CELL;
+	if(x < 0 || y < 0 || x >= SIZE || y >= SIZE) return false;
+	i = (uint8_t)x;
+	j = (uint8_t)y;
+	return true;
+}
+
+//!b Returns position (x,y) (m) of a cell centre.
+Vec2 FieldMap::center(uint8_t i, uint8_t j) {
+	return Vec2(
+		(i + 0.5) * CELL - HALF_SIZE,
+		(j + 0.5) * CELL - HALF_SIZE);
+}
+
+//!b Returns true if a sonar echo was last seen in the cell.
+bool FieldMap::occupied(uint8_t i, uint8_t j) {
+	return getBit(occupiedBits, i, j);
+}
+
+//!b Returns true if a sonar ray last passed through the cell.
+bool FieldMap::vacant(uint8_t i, uint8_t j) {
+	return getBit(vacantBits, i, j);
+}
+
+//!b Returns true if the flame sensor has seen the cell.
+bool FieldMap::swept(uint8_t i, uint8_t j) {
+	return getBit(sweptBits, i, j);
+}
+
+//!b Returns true if no occupied cell lies between two positions.
+//!i Start position (x,y) (m)
+//!i End position (x,y) (m)
+bool FieldMap::clearPath(const Vec2& a, const Vec2& b) {
+	Vec2 d = b - a;
+	float len = norm(d);
+	uint8_t i, j;
+	for(float s = 0; s < len; s += RAY_STEP) {
+		if(cellOf(a + d * (s / len), i, j) && occupied(i, j)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//!b Returns the nearest reachable frontier from the last pass.
+//!i Frontier cell centre (x,y) (m) (output)
+//!d A frontier is a vacant, unswept cell with a clear straight path
+//!d from the robot. Returns FRONTIER_FOUND and sets the target if
+//!d the last pass found one that is still a frontier, FRONTIER_NONE
+//!d if it found none, or FRONTIER_STALE if its frontier has since
+//!d been swept or reached, in which case the next pass is awaited.
+FieldMap::frontier_t FieldMap::frontier(Vec2& target) {
+	if(!frontierFound) return FRONTIER_NONE;
+	if(!isFrontier(frontierTarget)) return FRONTIER_STALE;
+	target = frontierTarget;
+	return FRONTIER_FOUND;
+}
+
+//!b Checks the next few cells of the frontier search.
+//!d Runs at most one clear path check per loop, and latches the
+//!d nearest frontier at the end of each pass over the map.
+void FieldMap::scanFrontier() {
+	for(uint8_t n = 0; n < SCAN_CELLS; n++) {
+		uint8_t i = scanCell % SIZE;
+		uint8_t j = scanCell / SIZE;
+		bool checked = false;
+		if(vacant(i, j) && !swept(i, j)) {
+			Vec2 c = center(i, j);
+			float d = norm(c - Odometer::position);
+			if(d >= FRONTIER_MIN && (scanBest < 0 || d < scanBest)) {
+				checked = true;
+				if(clearPath(Odometer::position, c)) {
+					scanBest = d;
+					scanTarget = c;
+				}
+			}
+		}
+		if(++scanCell == SIZE * SIZE) {
+			scanCell = 0;
+			frontierFound = (scanBest >= 0);
+			frontierTarget = scanTarget;
+			scanBest = -1;
+			return;
+		}
+		if(checked) return;
+	}
+}
+
+//!b Returns true if a cell centre is still an unswept frontier.
+//!d Only rechecks the cell, not the path to it.
+bool FieldMap::isFrontier(const Vec2& c) {
+	uint8_t i, j;
+	return cellOf(c, i, j) && vacant(i, j) && !swept(i, j) &&
+		norm(c - Odometer::position) >= FRONTIER_MIN;
+}
+
+//!b Returns a cell's bit from a bitset.
+bool FieldMap::getBit(const uint8_t* bits, uint8_t i, uint8_t j) {
+	uint16_t k = (uint16_t)j * SIZE + i;
+	return (bits[k >> 3] >> (k & 7)) & 1;
+}
+
+//!b Sets or clears a cell's bit in a bitset.
+void FieldMap::setBit(uint8_t* bits, uint8_t i, uint8_t j, bool v) {
+	uint16_t k = (uint16_t)j * SIZE + i;
+	if(v) bits[k >> 3] |= (1 << (k & 7));
+	else bits[k >> 3] &= ~(1 << (k & 7));
+}
@@ -0,0 +1,47 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FieldMap.h
+//!b Namespace for final project coarse field occupancy map.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d The field is a square grid of cells centred on the start
+//!d position. Each cell has three bits: occupied and vacant, set
+//!d by sonar rays, and swept, set by the flame sensor's line of
+//!d sight while panning. Vacant cells that have not been swept are
+//!d exploration frontiers for the flame search. Sonar rays only
+//!d mark cells vacant within the flame sweep range and the pan
+//!d range, so the robot can sweep every frontier it finds. The frontier search runs a
+//!d few cells per loop and latches its result once per pass.
+
+#pragma once
+#include "Arduino.h"
+#include "Linear.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace FieldMap {
+	const uint8_t SIZE = 20;	// Cells per side
+	const float CELL = 0.25;	// Cell side length (m)
+
+	enum frontier_t {
+		FRONTIER_NONE,
+		FRONTIER_FOUND,
+		FRONTIER_STALE,
+	};
+
+	void clear();
+	void loop();
+	void sweep();
+
+	bool cellOf(const Vec2&, uint8_t&, uint8_t&);
+	Vec2 center(uint8_t, uint8_t);
+	bool occupied(uint8_t, uint8_t);
+	bool vacant(uint8_t, uint8_t);
+	bool swept(uint8_t, uint8_t);
+	bool clearPath(const Vec2&, const Vec2&);
+	frontier_t frontier(Vec2&);
+}
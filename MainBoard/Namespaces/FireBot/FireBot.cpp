@@ -14,6 +14,20 @@
 #include "DriveSystem.h"
 #include "PanTilt.h"
 #include "MatlabComms.h"
+#include "Battery.h"
+#include "Mission.h"
+#include "Capture.h"
+#include "Trace.h"
+#include "LoopTimer.h"
+#include "Memory.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "FlameLocator.h"
+#include "FieldMap.h"
+#include "PathPlanner.h"
+#include "Relocalizer.h"
+#include "FlameSensor.h"
+#include "StateMachine.h"
 #include "BrushlessMotor.h"
 
 //*************************************************************//
@@ -23,33 +37,97 @@
 namespace FireBot {
 
 	// Arduino Pin Settings
-	const uint8_t PIN_FLAME_SENSOR = A0;
 	const uint8_t PIN_FAN = 8;
 
 	// Flame Finding
 	const int FLAME_FOUND_THRESHOLD = 750;	// (ADC)
+	const float FLAME_REJECT_DISTANCE = 0.3;	// Before re-checking (m)
+	const uint16_t FLAME_MISSED_MAX = 50;	// Confirm samples (0.5 s)
+	float flameRejectedAt = -1;	// Odometer distance (m) (-1 none)
 	int minFlameRead = 0;	// (ADC)
 	float flamePan = 0;		// (rad)
 	float flameHeading = 0;	// (rad)
 	float flameTilt = 0;	// (rad)
-	Vec flamePos(3);		// In (x, y, z) format (m)
+	Vec3 flamePos;		// In (x, y, z) format (m)
+
+	// Fault Snapshot
+	Fault fault;
+
+	// Frontier Exploration
+	// While searching, the robot leaves the wall to visit vacant
+	// cells the flame sensor has not yet swept, then drives
+	// straight until a wall is close and wall-follows again.
+	const bool EXPLORE = FIREBOT_EXPLORE;	// Enable exploration
+	const float EXPLORE_CHECK_PERIOD = 1.0;	// (s)
+	const float EXPLORE_RANGE = 1.5;		// Max frontier distance (m)
+	const float EXPLORE_SPEED = 0.2;		// (m/s)
+	const float EXPLORE_ARRIVE = 0.15;		// (m)
+	const float SEEK_WALL_DISTANCE = 0.4;	// (m)
+	enum explore_t {
+		EXPLORE_OFF,	// Wall-following
+		EXPLORE_DRIVE,	// Driving to frontier
+		EXPLORE_SEEK,	// Driving straight to a wall
+	} explore = EXPLORE_OFF;
+	Vec2 exploreTarget;		// (m)
+	float seekHeading = 0;	// (rad)
+	LoopTimer exploreTimer;
+
+	// Return Home
+	// The robot drives home along a path planned over the field
+	// map, and falls back to wall-following if the plan fails, an
+	// unmapped obstacle is in the way, or home takes too long.
+	const bool PLAN_HOME = true;			// Enable path planning
+	const float HOME_SPEED = 0.2;			// (m/s)
+	const float HOME_SLOW_DISTANCE = 0.5;	// Slows down within (m)
+	const float HOME_TURN_ANGLE = 0.6;		// Turns in place above (rad)
+	const float HOME_BLOCKED_DISTANCE = 0.3;	// Front sonar (m)
+	const float HOME_DRIVE_TIMEOUT = 30.0;	// (s)
+	enum home_t {
+		HOME_WALL,		// Wall-following (or seeking a wall)
+		HOME_PLAN,		// Planning path
+		HOME_DRIVE,		// Following path
+	} homeMode = HOME_WALL;
+	bool homeFine = false;	// Using the fine home threshold
+	bool homeTurning = false;	// Turning in place to waypoint
+	LoopTimer homeTimer;
 
 	// Driving to Candle
 	const float CANDLE_DRIVE_DISTANCE = 0.25;	// (m)
 	const float CANDLE_DRIVE_SPEED = 0.15;		// (m/s)
 	const float CANDLE_BASE_RADIUS = 0.06;		// (m)
-	float candleDriveTime = 0;	// (s)
-	Timer candleDriveTimer;
+	float candleDriveStart = 0;	// (m)
+	float candleDriveDist = 0;	// (m)
 
 	// Flame Extinguishing
 	const int FLAME_OUT_THRESHOLD = 850;	// (ADC)
 	const float FLAME_OUT_TIME = 5.0;		// (s)
+	const bool FAN_TRACKING = true;			// Track flame with fan
 	BrushlessMotor fan(PIN_FAN, 1000, 2000);
-	Timer flameTimer;
+	LoopTimer flameTimer;
+
+	// Boot Sequence
+	// Fan arming runs on into the mission, as it is only needed
+	// once the robot is aimed at the flame.
+	const float FAN_ARM_TIME = 5.0;			// (s)
+	const float IMU_SETTLE_TIME = 1.0;		// (s)
+	const uint16_t SONAR_BOOT_CYCLES = 2;	// Front sonar updates
+	bool connected = false;	// Matlab begin message received
+	LoopTimer bootTimer;
+
+	// Mission Checkpoints
+	// Saved to RAM periodically, and to EEPROM on state changes
+	// and at a slower period.
+	const float CHECKPOINT_PERIOD = 0.1;	// (s)
+	const float EEPROM_PERIOD = 2.0;		// (s)
+	uint8_t savedState = 0;	// Last checkpointed state
+	LoopTimer checkpointTimer;
+	LoopTimer eepromTimer;
 
 	// State Machine
 	enum {
-		STATE_SEARCH_FOR_FLAME = 1,
+		STATE_BOOT = 0,
+		STATE_SEARCH_FOR_FLAME,
+		STATE_CONFIRM_FLAME,
 		STATE_ZERO_PAN_SERVO,
 		STATE_GET_FLAME_HEADING,
 		STATE_TURN_TO_FLAME_HEADING,
@@ -62,41 +140,106 @@ namespace FireBot {
 		STATE_BACK_FROM_CANDLE,
 		STATE_TURN_TO_WALL,
 		STATE_GO_HOME,
-		STATE_AT_HOME
-	} state;
+		STATE_AT_HOME,
+		STATE_FAULT,
+		NUM_STATES,
+	};
+
+	// State Handlers
+	uint8_t stateBoot();
+	uint8_t stateSearchForFlame();
+	uint8_t stateConfirmFlame();
+	uint8_t stateZeroPanServo();
+	uint8_t stateGetFlameHeading();
+	uint8_t stateTurnToFlameHeading();
+	uint8_t stateDriveToCandle();
+	uint8_t stateLowerTiltServo();
+	uint8_t stateGetFlameTilt();
+	uint8_t stateAimAtFlame();
+	uint8_t stateExtinguishFlame();
+	uint8_t stateCheckFlame();
+	uint8_t stateBackFromCandle();
+	uint8_t stateTurnToWall();
+	uint8_t stateGoHome();
+	uint8_t stateAtHome();
+	uint8_t stateFault();
+
+	// State Transition Table
+	constexpr StateMachine<NUM_STATES>::Entry table[NUM_STATES] = {
+		{ nullptr, stateBoot },
+		{ nullptr, stateSearchForFlame },
+		{ nullptr, stateConfirmFlame },
+		{ nullptr, stateZeroPanServo },
+		{ nullptr, stateGetFlameHeading },
+		{ nullptr, stateTurnToFlameHeading },
+		{ nullptr, stateDriveToCandle },
+		{ nullptr, stateLowerTiltServo },
+		{ nullptr, stateGetFlameTilt },
+		{ nullptr, stateAimAtFlame },
+		{ nullptr, stateExtinguishFlame },
+		{ nullptr, stateCheckFlame },
+		{ nullptr, stateBackFromCandle },
+		{ nullptr, stateTurnToWall },
+		{ nullptr, stateGoHome },
+		{ nullptr, stateAtHome },
+		{ nullptr, stateFault },
+	};
+	StateMachine<NUM_STATES> machine(
+		table, STATE_BOOT, Trace::EVENT_FIREBOT_STATE);
+
+	// Private Function Templates
+	bool fanArmed();
+	void checkpoint();
+	void faultLoop();
+	void resume();
+	uint8_t resumeState(uint8_t);
+	void startExplore();
+	void exploreDrive();
+	void seekWall();
+	void planHome();
+	void driveHome();
+	void fallBackHome();
 }
 
 //*************************************************************//
 // NAMESPACE FUNCTION DEFINITIONS
 //*************************************************************//
 
-//!b Initializes FireBot.
-//!d Call this method in the main setup function.
+//!b Initializes FireBot and starts boot sequence.
+//!d Call this method in the main setup function. Slow startup
+//!d steps (fan arming, IMU settling, first sonar cycles, and the
+//!d Matlab connection) run in parallel in the boot state.
 void FireBot::setup() {
+	Capture::setup();
 	IndicatorLed::setup();
 
 	// Initialize Namespaces
 	if(!Odometer::setup()) error(1);	// Indicate IMU failure
 	if(!MatlabComms::setup()) error(2);	// Indicate Hc06 failure
+	Battery::setup();
 	DriveSystem::setup();
 	Sonar::setup();
 	WallFollower::setup();
 	PanTilt::setup();
 
 	// Initialize Flame Sensor and Fan
-	pinMode(PIN_FLAME_SENSOR, INPUT);
+	FlameSensor::setup();
 	fan.setup();
 	fan.arm();
-	delay(5000);
 
-	// Wait for Matlab begin message
-	IndicatorLed::led.on();
-	if(!MatlabComms::waitForBegin()) {
-		error(3);	// Indicate Matlab sent wrong byte
+	// Start boot sequence
+#if TRACE_ENABLED
+	Trace::measure();
+#endif
+	Memory::setup();
+	bootTimer.tic();
+	IndicatorLed::led.on();	// Ready for Matlab
+
+	// Resume mission after a watchdog or brown-out reset
+	if(Checkpoint::setup() && !inFault()) {
+		resume();
 	}
-
-	// Initialize state machine
-	state = STATE_SEARCH_FOR_FLAME;
+	Checkpoint::start();
 }
 
 //!b Executes repeatedly after Arduino reset.
@@ -104,196 +247,351 @@ void FireBot::setup() {
 void FireBot::loop() {
 
 	// Subsystem Updates
+	Capture::loop();	// Start input records for this loop
+	Checkpoint::loop();	// Reset watchdog and write EEPROM
+	if(inFault()) {
+		faultLoop();
+		return;
+	}
 	Odometer::loop();	// Update robot position and heading
 	PanTilt::loop();	// Update pan-tilt servos
+	Battery::loop();	// Update battery voltage
+	FlameSensor::loop();	// Sample flame sensor at fixed rate
+	Memory::loop();		// Update stack high-water mark
+	IndicatorLed::loop();	// Blink LED on warnings
 
 	// State Machine
-	switch(state) {
+	machine.loop();
+	if(inFault()) return;	// Nothing to checkpoint
+	Telemetry::publish();
+	if(machine.get() == STATE_BOOT) return;
+	FieldMap::loop();	// Map sonar readings
+	checkpoint();
 
-		// Wall-follow until flame detected
-		case STATE_SEARCH_FOR_FLAME:
-			WallFollower::loop();
-			PanTilt::sweep();
-			Sonar::loop();
-			if(flameDetected() &&
-				WallFollower::inPausableState())
-			{
-				WallFollower::stop();
-				PanTilt::stopTilt();
-				PanTilt::setPan(0);
-				state = STATE_ZERO_PAN_SERVO;
-			}
-			break;
+	// Check Messages from Matlab
+	switch(MatlabComms::loop()) {
+		case 1: error(1); break;	// No messages timeout
+		case 2: error(2); break;	// Invalid message type byte
+		default: break;
+	}
+	if(MatlabComms::disconnected) {	// Matlab sent DC message
+		error(0);
+	}
+}
 
-		// Zero the pan servo angle in prep for pan sweep.
-		case STATE_ZERO_PAN_SERVO:
-			if(PanTilt::isAimed()) {
-				minFlameRead = 1023;
-				PanTilt::setPan(PanTilt::PAN_MAX);
-				state = STATE_GET_FLAME_HEADING;
-			}
-			break;
+//!b Runs boot sequence until critical subsystems are ready.
+//!d Starts the mission once Matlab has connected, the IMU has
+//!d settled, and the sonar has completed its first cycles.
+uint8_t FireBot::stateBoot() {
+	Sonar::loop();
+	if(!connected) {
+		switch(MatlabComms::pollBegin()) {
+			case 1: connected = true; break;
+			case 2: error(3); break;	// Matlab sent wrong byte
+			default: break;
+		}
+	}
+	if(connected &&
+		bootTimer.hasElapsed(IMU_SETTLE_TIME) &&
+		Sonar::cycles >= SONAR_BOOT_CYCLES)
+	{
+		Odometer::zero();
+		Relocalizer::capture();
+		machine.clearTiming();
+		WallFollower::clearTiming();
+		Mission::start();
+		FlameLocator::reset();
+		FieldMap::clear();
+		exploreTimer.tic();
+		return STATE_SEARCH_FOR_FLAME;
+	}
+	return STATE_SAME;
+}
 
-		// Sweep pan servo to determine flame heading
-		case STATE_GET_FLAME_HEADING:
-			if(!PanTilt::isAimed()) {
-				int fr = analogRead(PIN_FLAME_SENSOR);
-				if(fr < minFlameRead) {
-					minFlameRead = fr;
-					flamePan = PanTilt::pan;
-				}
-			} else {
-				flameHeading = Odometer::heading + flamePan;
-				PanTilt::setPan(0);
-				state = STATE_TURN_TO_FLAME_HEADING;
-			}
+//!b Wall-follows and explores until flame detected.
+//!d Flame bearings from each pan sweep are triangulated on the
+//!d way. A detection stops the robot and the pan-tilt where they
+//!d are so the flicker can be checked. After a rejected flame,
+//!d the robot must move on a little before checking again.
+uint8_t FireBot::stateSearchForFlame() {
+	PanTilt::sweep();
+	Sonar::loop();
+	FieldMap::sweep();
+	FlameLocator::loop(FlameSensor::read());
+	switch(explore) {
+		case EXPLORE_OFF:
+			WallFollower::loop();
+			startExplore();
 			break;
+		case EXPLORE_DRIVE: exploreDrive(); break;
+		case EXPLORE_SEEK: seekWall(); break;
+	}
+	bool recheck = flameRejectedAt < 0 || fabs(Odometer::distance
+		- flameRejectedAt) >= FLAME_REJECT_DISTANCE;
+	if(recheck && flameDetected() && (explore != EXPLORE_OFF ||
+		WallFollower::inPausableState()))
+	{
+		WallFollower::stop();
+		DriveSystem::stop();
+		PanTilt::stopPan();
+		PanTilt::stopTilt();
+		FlameSensor::clear();
+		return STATE_CONFIRM_FLAME;
+	}
+	return STATE_SAME;
+}
 
-		// Zero pan servo angle and turn robot towards flame
-		case STATE_TURN_TO_FLAME_HEADING:
-			if(DriveSystem::drive(flameHeading) &&
-				PanTilt::isAimed())
-			{
-				DriveSystem::stop();
-				candleDriveTimer.tic();
-				state = STATE_DRIVE_TO_CANDLE;
-			}
-			break;
+//!b Checks the detected flame for flicker.
+//!d Waits for the flame sensor buffer to fill. Only a flickering
+//!d reading is taken as a flame. If the flame is real and the triangulated estimate is
+//!d valid, the robot turns straight to it and skips the pan
+//!d sweep. Otherwise, or if the loop was too slow to hold the
+//!d sample rate, the search carries on where it stopped.
+uint8_t FireBot::stateConfirmFlame() {
+	bool late = FlameSensor::missed() > FLAME_MISSED_MAX;
+	if(!late && !FlameSensor::full()) return STATE_SAME;
+	bool flame = !late && FlameSensor::flickering();
+	if(!flame) {
+		flameRejectedAt = Odometer::distance;
+		if(explore == EXPLORE_OFF) WallFollower::start();
+		return STATE_SEARCH_FOR_FLAME;
+	}
+	PanTilt::setPan(0);
+	Mission::mark(Mission::EVENT_FLAME_FOUND);
+	if(FlameLocator::hasEstimate()) {
+		Vec2 d = FlameLocator::estimate() - Odometer::position;
+		flameHeading = atan2(d.x, d.y);
+		return STATE_TURN_TO_FLAME_HEADING;
+	}
+	return STATE_ZERO_PAN_SERVO;
+}
 
-		// Drive up close to candle
-		case STATE_DRIVE_TO_CANDLE: {
-			float candleDist = Sonar::pingFront();
-			if(candleDist != 0 && candleDist <
-				CANDLE_DRIVE_DISTANCE)
-			{
-				DriveSystem::stop();
-				candleDriveTime = candleDriveTimer.toc();
-				state = STATE_LOWER_TILT_SERVO;
-			} else {
-				DriveSystem::drive(flameHeading,
-					CANDLE_DRIVE_SPEED);
-			}
-			break;
+//!b Zeroes the pan servo angle in prep for pan sweep.
+uint8_t FireBot::stateZeroPanServo() {
+	if(PanTilt::isAimed()) {
+		minFlameRead = 1023;
+		PanTilt::setPan(PanTilt::PAN_MAX);
+		return STATE_GET_FLAME_HEADING;
+	}
+	return STATE_SAME;
+}
+
+//!b Sweeps pan servo to determine flame heading.
+uint8_t FireBot::stateGetFlameHeading() {
+	if(!PanTilt::isAimed()) {
+		int fr = FlameSensor::read();
+		if(fr < minFlameRead) {
+			minFlameRead = fr;
+			flamePan = PanTilt::pan;
 		}
+		return STATE_SAME;
+	}
+	flameHeading = Odometer::heading + flamePan;
+	PanTilt::setPan(0);
+	return STATE_TURN_TO_FLAME_HEADING;
+}
 
-		// Lower tilt servo in prep for tilt sweep
-		case STATE_LOWER_TILT_SERVO:
-			if(PanTilt::isAimed()) {
-				PanTilt::setTilt(PanTilt::TILT_MAX);
-				flameTilt = PanTilt::tilt;
-				minFlameRead = 1023;
-				state = STATE_GET_FLAME_TILT;
-			}
-			break;
+//!b Zeroes pan servo angle and turns robot towards flame.
+uint8_t FireBot::stateTurnToFlameHeading() {
+	if(DriveSystem::turn(flameHeading) &&
+		PanTilt::isAimed())
+	{
+		DriveSystem::stop();
+		candleDriveStart = Odometer::distance;
+		return STATE_DRIVE_TO_CANDLE;
+	}
+	return STATE_SAME;
+}
 
-		// Sweep tilt servo up to find flame tilt
-		case STATE_GET_FLAME_TILT:
-			if(!PanTilt::isAimed()) {
-				int fr = analogRead(PIN_FLAME_SENSOR);
-				if(fr < minFlameRead) {
-					minFlameRead = fr;
-					flameTilt = PanTilt::tilt;
-				}
-			} else {
-				computeFlamePosition();
-				PanTilt::setTilt(flameTilt);
-				state = STATE_AIM_AT_FLAME;
-			}
-			break;
+//!b Drives up close to candle.
+uint8_t FireBot::stateDriveToCandle() {
+	float candleDist = Sonar::pingFront();
+	if(candleDist != 0 && candleDist <
+		CANDLE_DRIVE_DISTANCE)
+	{
+		DriveSystem::stop();
+		candleDriveDist =
+			Odometer::distance - candleDriveStart;
+		return STATE_LOWER_TILT_SERVO;
+	}
+	DriveSystem::drive(flameHeading,
+		CANDLE_DRIVE_SPEED);
+	return STATE_SAME;
+}
 
-		// Aim fan at flame
-		case STATE_AIM_AT_FLAME:
-			if(PanTilt::isAimed()) {
-				fan.setSpeed(1.0);
-				flameTimer.tic();
-				state = STATE_EXTINGUISH_FLAME;
-			}
-			break;
+//!b Lowers tilt servo in prep for tilt sweep.
+uint8_t FireBot::stateLowerTiltServo() {
+	if(PanTilt::isAimed()) {
+		PanTilt::setTilt(PanTilt::TILT_MAX);
+		flameTilt = PanTilt::tilt;
+		minFlameRead = 1023;
+		return STATE_GET_FLAME_TILT;
+	}
+	return STATE_SAME;
+}
 
-		// Extinguish the flame
-		case STATE_EXTINGUISH_FLAME:
-			flameTimer.tic();
-			if(flameExtinguished()) {
-				state = STATE_CHECK_FLAME;
-			}
-			break;
+//!b Sweeps tilt servo up to find flame tilt.
+uint8_t FireBot::stateGetFlameTilt() {
+	if(!PanTilt::isAimed()) {
+		int fr = FlameSensor::read();
+		if(fr < minFlameRead) {
+			minFlameRead = fr;
+			flameTilt = PanTilt::tilt;
+		}
+		return STATE_SAME;
+	}
+	computeFlamePosition();
+	PanTilt::setTilt(flameTilt);
+	return STATE_AIM_AT_FLAME;
+}
 
-		// Run fan extra time to assur flame is out
-		case STATE_CHECK_FLAME:
-			if(!flameExtinguished()) {
-				state = STATE_EXTINGUISH_FLAME;
-			} else if(flameTimer.hasElapsed(FLAME_OUT_TIME)) {
-				fan.setSpeed(0.0);
-				candleDriveTimer.tic();
-				state = STATE_BACK_FROM_CANDLE;
-			}
-			break;
+//!b Aims fan at flame.
+//!d Waits for the fan to finish arming if it has not.
+uint8_t FireBot::stateAimAtFlame() {
+	if(PanTilt::isAimed() && fanArmed()) {
+		fan.setSpeed(1.0);
+		flameTimer.tic();
+		if(FAN_TRACKING) PanTilt::startTracking();
+		return STATE_EXTINGUISH_FLAME;
+	}
+	return STATE_SAME;
+}
 
-		// Drive back from candle to wall-follow position
-		case STATE_BACK_FROM_CANDLE:
-			if(candleDriveTimer.hasElapsed(candleDriveTime)) {
-				DriveSystem::stop();
-				state = STATE_TURN_TO_WALL;
-			} else {
-				DriveSystem::drive(flameHeading,
-					-CANDLE_DRIVE_SPEED);
-			}
-			break;
+//!b Extinguishes the flame.
+//!d The fan tracks the flame while it runs, if enabled.
+uint8_t FireBot::stateExtinguishFlame() {
+	flameTimer.tic();
+	if(FAN_TRACKING) PanTilt::track(FlameSensor::read());
+	if(flameExtinguished()) {
+		return STATE_CHECK_FLAME;
+	}
+	return STATE_SAME;
+}
 
-		// Turn robot back towards wall-following heading
-		case STATE_TURN_TO_WALL:
-			if(DriveSystem::drive(
-				WallFollower::targetHeading()))
-			{
-				WallFollower::start();
-				state = STATE_GO_HOME;
-			}
-			break;
+//!b Runs fan extra time to assure flame is out.
+uint8_t FireBot::stateCheckFlame() {
+	if(FAN_TRACKING) PanTilt::track(FlameSensor::read());
+	if(!flameExtinguished()) {
+		return STATE_EXTINGUISH_FLAME;
+	} else if(flameTimer.hasElapsed(FLAME_OUT_TIME)) {
+		fan.setSpeed(0.0);
+		Mission::mark(Mission::EVENT_EXTINGUISHED);
+		return STATE_BACK_FROM_CANDLE;
+	}
+	return STATE_SAME;
+}
 
-		// Wall-follow until near home position
-		case STATE_GO_HOME:
-			WallFollower::loop();
-			Sonar::loop();
-			if(Odometer::nearHome()) {
-				WallFollower::stop();
-				state = STATE_AT_HOME;
-			}
-			break;
+//!b Drives back from candle to wall-follow position.
+uint8_t FireBot::stateBackFromCandle() {
+	if(DriveSystem::driveDistance(flameHeading,
+		-candleDriveDist))
+	{
+		DriveSystem::stop();
+		return STATE_TURN_TO_WALL;
+	}
+	return STATE_SAME;
+}
 
-		// Sit around. Good job, robot!
-		case STATE_AT_HOME:
-			break;
+//!b Turns robot back towards wall-following heading.
+//!d Starts planning a path home if enabled. Otherwise, if the
+//!d flame was found while exploring, the robot seeks a wall
+//!d before wall-following home.
+uint8_t FireBot::stateTurnToWall() {
+	if(DriveSystem::turn(
+		WallFollower::targetHeading()))
+	{
+		DriveSystem::stop();
+		if(PLAN_HOME) {
+			PathPlanner::start(Vec2());
+			homeMode = HOME_PLAN;
+		} else if(explore != EXPLORE_OFF) {
+			seekHeading = WallFollower::targetHeading();
+			explore = EXPLORE_SEEK;
+		} else {
+			WallFollower::start();
+		}
+		return STATE_GO_HOME;
 	}
+	return STATE_SAME;
+}
 
-	// Check Messages from Matlab
-	switch(MatlabComms::loop()) {
-		case 1: error(1); break;	// No messages timeout
-		case 2: error(2); break;	// Invalid message type byte
-		default: break;
+//!b Drives or wall-follows until near home position.
+//!d Odometry is relocalized against the start sonar signature
+//!d near home. Once the pose has been relocalized while following
+//!d the path, the robot drives on to the tighter home threshold.
+uint8_t FireBot::stateGoHome() {
+	Sonar::loop();
+	Relocalizer::loop();
+	switch(homeMode) {
+		case HOME_PLAN: planHome(); break;
+		case HOME_DRIVE: driveHome(); break;
+		case HOME_WALL:
+			if(explore == EXPLORE_SEEK) seekWall();
+			else WallFollower::loop();
+			break;
 	}
-	if(MatlabComms::disconnected) {	// Matlab sent DC message
-		error(0);
+	if(homeMode == HOME_DRIVE && Relocalizer::locked()) {
+		homeFine = true;
 	}
+	if(Odometer::nearHome(homeFine && homeMode == HOME_DRIVE)) {
+		WallFollower::stop();
+		DriveSystem::stop();
+		Mission::mark(Mission::EVENT_AT_HOME);
+		Checkpoint::finish();
+		return STATE_AT_HOME;
+	}
+	return STATE_SAME;
+}
+
+//!b Sits around. Good job, robot!
+uint8_t FireBot::stateAtHome() {
+	return STATE_SAME;
+}
+
+//!b Waits for Matlab to clear the fault (see faultLoop).
+uint8_t FireBot::stateFault() {
+	return STATE_SAME;
 }
 
 //!b Returns byte enumerating current robot state
 byte FireBot::getState() {
-	return (byte)state;
+	return machine.get();
+}
+
+//!b Returns number of state numbers (including unused state 0).
+uint8_t FireBot::numStates() {
+	return NUM_STATES;
+}
+
+//!b Returns cumulative time (s) spent in given state.
+float FireBot::dwellTime(uint8_t state) {
+	return machine.dwellTime(state);
+}
+
+//!b Returns number of times given state was entered.
+uint16_t FireBot::entries(uint8_t state) {
+	return machine.entries(state);
+}
+
+//!b Returns true if the fan has been held at arming speed long
+//!b enough to run.
+bool FireBot::fanArmed() {
+	return bootTimer.hasElapsed(FAN_ARM_TIME);
 }
 
 //!b Returns true if flame is detected by flame sensor.
 bool FireBot::flameDetected() {
-	return analogRead(PIN_FLAME_SENSOR) < FLAME_FOUND_THRESHOLD;
+	return FlameSensor::read() < FLAME_FOUND_THRESHOLD;
 }
 
 //!b Returns true if flame is extinguished by fan.
 //!d Assumes flame sensor is pointed directly at flame.
 bool FireBot::flameExtinguished() {
-	return analogRead(PIN_FLAME_SENSOR) > FLAME_OUT_THRESHOLD;
+	return FlameSensor::read() > FLAME_OUT_THRESHOLD;
 }
 
 //!b Computes flame position (x, y, z) relative to field origin.
-//!d Stores result in 3-dimensional 'flamePos' vector.
+//!d Stores result in 'flamePos' vector.
 void FireBot::computeFlamePosition() {
 	float cy = CANDLE_DRIVE_DISTANCE + CANDLE_BASE_RADIUS;
 	float d1 = cy + RobotDims::dBTy
@@ -301,15 +599,321 @@ void FireBot::computeFlamePosition() {
 	float d2 = RobotDims::dBTz
 				+ (RobotDims::dTS * cos(flameTilt));
 	float d3 = d1 * tan(flameTilt);
-	flamePos(1) = Odometer::position(1) + cy * sin(flameHeading);
-	flamePos(2) = Odometer::position(2) + cy * cos(flameHeading);
-	flamePos(3) = d2 + d3;
+	flamePos.x = Odometer::position.x + cy * sin(flameHeading);
+	flamePos.y = Odometer::position.y + cy * cos(flameHeading);
+	flamePos.z = d2 + d3;
+}
+
+//!b Checkpoints the mission periodically and on state changes.
+void FireBot::checkpoint() {
+	uint8_t state = machine.get();
+	bool changed = (state != savedState);
+	if(!changed && !checkpointTimer.hasElapsed(CHECKPOINT_PERIOD)) {
+		return;
+	}
+	checkpointTimer.tic();
+	savedState = state;
+
+	// Fill in record
+	Checkpoint::Record& r = Checkpoint::record;
+	r.fireBotState = state;
+	r.wallState = WallFollower::getState();
+	r.wallPausedState = WallFollower::getPausedState();
+	r.wallDirection = WallFollower::getDirection();
+	r.x = Odometer::position.x;
+	r.y = Odometer::position.y;
+	r.distance = Odometer::distance;
+	r.heading = Odometer::heading;
+	r.flameHeading = flameHeading;
+	r.flameTilt = flameTilt;
+	r.candleDriveStart = candleDriveStart;
+	r.candleDriveDist = candleDriveDist;
+	r.flamePos[0] = flamePos.x;
+	r.flamePos[1] = flamePos.y;
+	r.flamePos[2] = flamePos.z;
+	r.missionTime = Mission::elapsed();
+	for(uint8_t i = 0; i < Mission::NUM_EVENTS; i++) {
+		r.eventTimes[i] = Mission::time((Mission::event_t)i);
+	}
+	r.faultCode = Mission::faultCode;
+	for(uint8_t i = 0; i < 4; i++) {
+		r.homeSignature[i] = Relocalizer::signature[i];
+	}
+
+	// Save record
+	bool toEeprom = changed || eepromTimer.hasElapsed(EEPROM_PERIOD);
+	if(toEeprom) eepromTimer.tic();
+	Checkpoint::save(toEeprom);
+}
+
+//!b Resumes mission from the checkpoint record.
+//!d Skips the boot sequence. The fan still arms in the
+//!d background before it is used.
+void FireBot::resume() {
+	const Checkpoint::Record& r = Checkpoint::record;
+	Odometer::resume(Vec2(r.x, r.y), r.distance, r.heading);
+	WallFollower::resume(
+		r.wallState, r.wallPausedState, r.wallDirection);
+	flameHeading = r.flameHeading;
+	flameTilt = r.flameTilt;
+	candleDriveStart = r.candleDriveStart;
+	candleDriveDist = r.candleDriveDist;
+	flamePos = Vec3(r.flamePos[0], r.flamePos[1], r.flamePos[2]);
+	for(uint8_t i = 0; i < 4; i++) {
+		Relocalizer::signature[i] = r.homeSignature[i];
+	}
+	Mission::resume(r.missionTime, r.eventTimes,
+		r.faultCode, r.resumes);
+	connected = true;
+	MatlabComms::resume();
+	uint8_t state = resumeState(r.fireBotState);
+	if((state == STATE_SEARCH_FOR_FLAME || state == STATE_GO_HOME) &&
+		WallFollower::isStopped())
+	{
+		seekHeading = Odometer::heading;	// Was off the wall
+		explore = EXPLORE_SEEK;
+	}
+	savedState = state;
+	machine.set(state);
+	machine.clearTiming();
+}
+
+//!b Returns state to resume in for a checkpointed state.
+//!d Sweeps restart from their beginning, the fan is re-aimed
+//!d before it runs, and backing from the candle cannot resume
+//!d part way so the robot turns back to the wall instead. A
+//!d flame being confirmed is found again by the search. The
+//!d caller restores the exploration and return home modes.
+uint8_t FireBot::resumeState(uint8_t state) {
+	switch(state) {
+		case STATE_ZERO_PAN_SERVO:
+		case STATE_GET_FLAME_HEADING:
+			PanTilt::stopTilt();
+			PanTilt::setPan(0);
+			return STATE_ZERO_PAN_SERVO;
+		case STATE_LOWER_TILT_SERVO:
+		case STATE_GET_FLAME_TILT:
+			return STATE_LOWER_TILT_SERVO;
+		case STATE_AIM_AT_FLAME:
+		case STATE_EXTINGUISH_FLAME:
+		case STATE_CHECK_FLAME:
+			PanTilt::setTilt(flameTilt);
+			return STATE_AIM_AT_FLAME;
+		case STATE_BACK_FROM_CANDLE:
+			return STATE_TURN_TO_WALL;
+		case STATE_SEARCH_FOR_FLAME:
+		case STATE_CONFIRM_FLAME:
+		case STATE_GO_HOME:
+			return (state == STATE_CONFIRM_FLAME) ?
+				(uint8_t)STATE_SEARCH_FOR_FLAME : state;
+		default:
+			return state;
+	}
+}
+
+//!b Leaves the wall to explore if a frontier is in range.
+//!d Reads the latest frontier search pass, which FieldMap spreads
+//!d over several loops. Only checks periodically so the robot
+//!d keeps to the wall for a while after rejoining it.
+void FireBot::startExplore() {
+	if(!EXPLORE ||
+		!WallFollower::inPausableState() ||
+		!exploreTimer.hasElapsed(EXPLORE_CHECK_PERIOD))
+	{
+		return;
+	}
+	exploreTimer.tic();
+	if(FieldMap::frontier(exploreTarget) == FieldMap::FRONTIER_FOUND &&
+		norm(exploreTarget - Odometer::position) <= EXPLORE_RANGE)
+	{
+		WallFollower::stop();
+		explore = EXPLORE_DRIVE;
+	}
+}
+
+//!b Drives to the exploration frontier.
+//!d Moves on to the next frontier once the target is reached or
+//!d swept, stopping until the frontier search catches up, and
+//!d seeks a wall if none is in range. Hands back to the
+//!d wall-follower if a wall or cliff is in the way.
+void FireBot::exploreDrive() {
+	if(WallFollower::nearCliff() || (Sonar::distF != 0 &&
+		Sonar::distF < SEEK_WALL_DISTANCE))
+	{
+		WallFollower::restart();
+		explore = EXPLORE_OFF;
+		return;
+	}
+	uint8_t i, j;
+	Vec2 d = exploreTarget - Odometer::position;
+	if(norm(d) < EXPLORE_ARRIVE || (FieldMap::cellOf(
+		exploreTarget, i, j) && FieldMap::swept(i, j)))
+	{
+		FieldMap::frontier_t f = FieldMap::frontier(exploreTarget);
+		if(f == FieldMap::FRONTIER_STALE) {
+			DriveSystem::stop();
+			return;
+		}
+		if(f == FieldMap::FRONTIER_NONE ||
+			norm(exploreTarget - Odometer::position) > EXPLORE_RANGE)
+		{
+			seekHeading = Odometer::heading;
+			explore = EXPLORE_SEEK;
+		}
+		return;
+	}
+	DriveSystem::drive(atan2(d.x, d.y), EXPLORE_SPEED);
+}
+
+//!b Drives straight until a wall is close, then wall-follows.
+void FireBot::seekWall() {
+	if(WallFollower::nearCliff() ||
+		(Sonar::distF != 0 && Sonar::distF < SEEK_WALL_DISTANCE) ||
+		(Sonar::distL != 0 && Sonar::distL < SEEK_WALL_DISTANCE))
+	{
+		WallFollower::restart();
+		explore = EXPLORE_OFF;
+		exploreTimer.tic();
+		return;
+	}
+	DriveSystem::drive(seekHeading, EXPLORE_SPEED);
+}
+
+//!b Runs the home path planner while stopped.
+void FireBot::planHome() {
+	switch(PathPlanner::loop()) {
+		case PathPlanner::PLAN_FOUND:
+			homeMode = HOME_DRIVE;
+			homeTurning = false;
+			homeTimer.tic();
+			break;
+		case PathPlanner::PLAN_FAILED: fallBackHome(); break;
+		default: break;
+	}
+}
+
+//!b Drives towards the next waypoint of the home path.
+//!d Turns in place when the waypoint is well off the heading,
+//!d and slows down near home so the turning circle stays inside
+//!d the home threshold. The front sonar is ignored within the
+//!d final cell, where home may be close to a wall.
+void FireBot::driveHome() {
+	Vec2 wp;
+	float home = norm(Odometer::position);
+	bool blocked = (home > FieldMap::CELL && Sonar::distF != 0 &&
+		Sonar::distF < HOME_BLOCKED_DISTANCE);
+	if(WallFollower::nearCliff() || blocked ||
+		homeTimer.hasElapsed(HOME_DRIVE_TIMEOUT) ||
+		!PathPlanner::waypoint(wp))
+	{
+		fallBackHome();
+		return;
+	}
+	Vec2 d = wp - Odometer::position;
+	float ht = atan2(d.x, d.y);
+	float e = ht - Odometer::heading;
+	if(fabs(atan2(sin(e), cos(e))) > HOME_TURN_ANGLE) {
+		homeTurning = true;
+	}
+	if(homeTurning) {
+		if(DriveSystem::turn(ht)) homeTurning = false;
+		return;
+	}
+	float v = HOME_SPEED;
+	if(home < HOME_SLOW_DISTANCE) v *= home / HOME_SLOW_DISTANCE;
+	DriveSystem::drive(ht, v);
+}
+
+//!b Finds a wall and wall-follows home instead of the path.
+void FireBot::fallBackHome() {
+	seekHeading = Odometer::heading;
+	explore = EXPLORE_SEEK;
+	homeMode = HOME_WALL;
 }
 
-//!b Stops robot driving and flashes LED n times in a loop.
-//!d This is used to indicate Serial or I2C communication errors.
+//!b Stops robot and enters fault mode.
+//!i Fault code:
+//!i - 0: Matlab disconnected
+//!i - 1: IMU failure or Matlab message timeout
+//!i - 2: Hc06 failure or invalid message type byte
+//!i - 3: Matlab sent wrong connect byte
+//!d The motors and fan stop and a snapshot of the robot is
+//!d frozen for Matlab. The LED flashes the fault code and
+//!d Matlab messages are still answered until the fault is
+//!d cleared. A reset during a fault does not resume the mission.
+//!d Only the first fault is kept if several occur in one loop.
 void FireBot::error(uint8_t n) {
+	if(inFault()) return;
+
+	// Freeze snapshot
+	fault.code = n;
+	fault.state = machine.get();
+	fault.wallState = WallFollower::getState();
+	fault.explore = explore;
+	fault.homeMode = homeMode;
+	homeTimer.pause();
+	fault.time = Mission::elapsed();
+	fault.position = Odometer::position;
+	fault.heading = Odometer::heading;
+	fault.distF = Sonar::distF;
+	fault.distB = Sonar::distB;
+	fault.distL = Sonar::distL;
+	fault.distR = Sonar::distR;
+	fault.battery = Battery::voltage;
+
+	// Stop robot
 	fan.setSpeed(0.0);
 	DriveSystem::stop();
-	IndicatorLed::flash(n);
+	WallFollower::stop();
+	Mission::fail(n);
+
+	// Enter fault mode
+	if(fault.state != STATE_BOOT) {
+		Checkpoint::record.fireBotState = STATE_BOOT;
+		Checkpoint::save(true);
+	}
+	Checkpoint::finish();
+	IndicatorLed::fault(n);
+	machine.set(STATE_FAULT);
 }
+
+//!b Returns true if robot is in fault mode.
+bool FireBot::inFault() {
+	return machine.get() == STATE_FAULT;
+}
+
+//!b Leaves fault mode and resumes the state the fault occurred in.
+//!d Returns false if robot is not in fault mode. The robot goes
+//!d back to exactly the exploration or return home mode it was
+//!d in, and wall-follows again only if it was wall-following.
+bool FireBot::clearFault() {
+	if(!inFault()) return false;
+	IndicatorLed::clearFault();
+	connected = true;	// Matlab sent the clear message
+	MatlabComms::disconnected = false;
+	MatlabComms::resume();
+	uint8_t state = resumeState(fault.state);
+	explore = (explore_t)fault.explore;
+	homeMode = (home_t)fault.homeMode;
+	homeTimer.resume();
+	bool wallFollowing =
+		(state == STATE_SEARCH_FOR_FLAME && explore == EXPLORE_OFF) ||
+		(state == STATE_GO_HOME && homeMode == HOME_WALL &&
+			explore == EXPLORE_OFF);
+	if(wallFollowing) WallFollower::start();
+	Checkpoint::start();	// Resumable again
+	machine.set(state);
+	return true;
+}
+
+//!b Runs minimal loop while in fault mode.
+//!d Keeps the LED pattern and Matlab replies going. Matlab
+//!d errors and disconnects are ignored until the fault clears.
+void FireBot::faultLoop() {
+	Battery::loop();
+	IndicatorLed::loop();
+	Telemetry::publish();
+	MatlabComms::loop();
+	MatlabComms::disconnected = false;
+}
+
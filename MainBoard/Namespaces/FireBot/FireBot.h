@@ -11,23 +11,50 @@
 //!d for debug purposes.
 
 #include "Arduino.h"
-#include "LinearAtmel.h"
+#include "Linear.h"
+
+// Set to 0 to only wall-follow during the flame search
+#ifndef FIREBOT_EXPLORE
+#define FIREBOT_EXPLORE 1
+#endif
 
 //*************************************************************//
 // NAMESPACE DECLARATION
 //*************************************************************//
 
 namespace FireBot {
-	extern Vec flamePos;
+	struct Fault {
+		uint8_t code;		// Fault code (see error)
+		uint8_t state;		// State when fault occurred
+		uint8_t wallState;	// Wall-follower state
+		uint8_t explore;	// Exploration mode (not sent)
+		uint8_t homeMode;	// Return home mode (not sent)
+		float time;			// Mission time (s)
+		Vec2 position;		// (m)
+		float heading;		// (rad)
+		float distF;		// Sonar distances (m)
+		float distB;
+		float distL;
+		float distR;
+		float battery;		// (V)
+	};
+
+	extern Vec3 flamePos;
+	extern Fault fault;
 
 	void setup();
 	void loop();
 	byte getState();
+	uint8_t numStates();
+	float dwellTime(uint8_t);
+	uint16_t entries(uint8_t);
 
 	bool flameDetected();
 	bool flameExtinguished();
 	void computeFlamePosition();
 
 	void error(uint8_t);
+	bool inFault();
+	bool clearFault();
 }
 
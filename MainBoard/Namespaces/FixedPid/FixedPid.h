@@ -0,0 +1,350 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FixedPid.h
+//!b Template class for fixed-point PID control.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This class is a drop-in replacement for PidController which
+//!d runs in Q-format integer arithmetic, since the Mega has no
+//!d FPU. Errors are 16-bit with Q fractional bits, set at compile
+//!d time per controller so the error range fits (Q = 12 covers
+//!d +/-8). Gains are 32-bit Q16. Every product is a 16-bit value
+//!d times a 32-bit one, split into two 16 x 16 multiplies, so no
+//!d 64-bit arithmetic is used. Errors are given either as floats,
+//!d converted at the interface, or in Q-format with updateFixed().
+//!d
+//!d The time step is the loop clock difference in integer
+//!d microseconds, measured per controller. Each controller caches
+//!d ki * dt, kb * dt, and 1 / dt for its own step, and only
+//!d recomputes them (in float) when its step changes by more than
+//!d 1/64, so steady loops do no division at all. The integrator
+//!d is a 32-bit accumulator with 14 extra fractional bits, so the
+//!d ki * e * dt products of small gains at short steps are not
+//!d rounded away. It is held within the output magnitude so it
+//!d cannot overflow.
+//!d
+//!d The derivative term is low-pass filtered with a gain of
+//!d 2^-DSHIFT per update, and saturates at the 16-bit error
+//!d range per second. Integrator windup is limited by back-
+//!d calculation: the difference between saturated and raw output
+//!d is fed back into the integrator at the tracking gain kb. By
+//!d default kb = 1/Tt with Tt = sqrt(Ti * Td), or Ti if there is
+//!d no derivative term. Back-calculation only bleeds off stored
+//!d integral and never drives it past zero, so a large
+//!d proportional term cannot wind it the other way. The
+//!d integrator and filter reset if the controller is not updated
+//!d within the reset time, as with PidController. Gains can be
+//!d changed on the fly without a bump in the output. Entry into
+//!d saturation is logged to the event trace if a trace id is set.
+
+#pragma once
+#include "Arduino.h"
+#include "Capture.h"
+#include "Trace.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+template<uint8_t Q, uint8_t DSHIFT = 2>
+class FixedPid {
+public:
+	typedef int16_t error_t;
+	typedef int32_t fixed_t;
+
+	FixedPid(float, float, float, float, float,
+		float = 0, float = -1);
+
+	float update(float);
+	float update(float, float);
+	fixed_t updateFixed(error_t);
+	fixed_t updateFixed(error_t, uint32_t);
+	bool steadyState(float, float);
+	void reset();
+	void setGains(float, float, float);
+	void setTraceId(uint8_t);
+	bool saturated() const;
+
+	static error_t toError(float);
+	static fixed_t toFixed(float);
+	static float toFloat(fixed_t);
+
+private:
+	static_assert(Q <= 14, "Q leaves no integer bits for errors");
+
+	static const uint8_t IQ = 14;	// Extra integrator bits
+	static const uint8_t STEP_TOLERANCE = 6;	// Recompute at 2^-6
+
+	static fixed_t mul(error_t, fixed_t);
+	static error_t clamp16(fixed_t);
+	static float trackingGain(float, float, float);
+	void setStep(uint32_t);
+
+	fixed_t kp, ki, kd, kb;		// Q16
+	bool autoKb;
+	fixed_t outMin, outMax;
+	fixed_t integralMax;	// Q(Q + IQ)
+	uint32_t resetUs;
+
+	// Time Step Cache
+	uint32_t stepUs;
+	fixed_t kiStep;		// ki * dt (Q30)
+	fixed_t kbStep;		// kb * dt (Q30)
+	fixed_t invStep;	// 1 / dt (1/s) (Q16)
+
+	fixed_t integral;	// Q(Q + IQ)
+	error_t derivative;
+	error_t lastError;
+	error_t lastDelta;
+	bool begun;
+	bool sat;
+	uint8_t traceId;
+	uint32_t lastUs;
+};
+
+//**************************************************************/
+// CLASS FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Constructs PID controller.
+//!i Proportional gain
+//!i Integral gain
+//!i Derivative gain
+//!i Minimum output
+//!i Maximum output
+//!i Reset time (s) (0 to disable)
+//!i Back-calculation tracking gain (1/s) (negative for default)
+template<uint8_t Q, uint8_t DSHIFT>
+FixedPid<Q, DSHIFT>::FixedPid(
+	float kp, float ki, float kd,
+	float outMin, float outMax,
+	float resetTime, float kb)
+{
+	this->kp = (fixed_t)(kp * 65536.0);
+	this->ki = (fixed_t)(ki * 65536.0);
+	this->kd = (fixed_t)(kd * 65536.0);
+	autoKb = (kb < 0);
+	if(autoKb) kb = trackingGain(kp, ki, kd);
+	this->kb = (fixed_t)(kb * 65536.0);
+	this->outMin = toFixed(outMin);
+	this->outMax = toFixed(outMax);
+	integralMax = max(abs(this->outMin), abs(this->outMax)) *
+		(1L << IQ);
+	this->resetUs = resetTime * 1e6;
+	traceId = 0;
+	stepUs = 0;
+	kiStep = 0;
+	kbStep = 0;
+	invStep = 0;
+	reset();
+}
+
+//!b Updates controller with error, timing the update itself.
+//!i Error (setpoint - feedback)
+//!d Returns controller output.
+template<uint8_t Q, uint8_t DSHIFT>
+float FixedPid<Q, DSHIFT>::update(float error) {
+	return toFloat(updateFixed(toError(error)));
+}
+
+//!b Updates controller with error and explicit time step.
+//!i Error (setpoint - feedback)
+//!i Time step since last update (s)
+//!d Returns controller output.
+template<uint8_t Q, uint8_t DSHIFT>
+float FixedPid<Q, DSHIFT>::update(float error, float dt) {
+	return toFloat(updateFixed(toError(error), dt * 1e6));
+}
+
+//!b Updates controller with Q-format error, timing the update
+//!b itself on the loop clock.
+//!i Error (setpoint - feedback) (Q-format)
+//!d Returns controller output (Q-format).
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::fixed_t
+FixedPid<Q, DSHIFT>::updateFixed(error_t e) {
+	uint32_t now = Capture::micros();
+	uint32_t dtUs = now - lastUs;
+	lastUs = now;
+	return updateFixed(e, dtUs);
+}
+
+//!b Updates controller with Q-format error and time step.
+//!i Error (setpoint - feedback) (Q-format)
+//!i Time step since last update (us)
+//!d Returns controller output (Q-format).
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::fixed_t
+FixedPid<Q, DSHIFT>::updateFixed(error_t e, uint32_t dtUs) {
+
+	// Reset if controller has not run recently
+	if(!begun || (resetUs > 0 && dtUs > resetUs)) {
+		integral = 0;
+		derivative = 0;
+		lastError = e;
+		begun = true;
+		dtUs = 0;
+	}
+	uint32_t dStep = (dtUs > stepUs) ? dtUs - stepUs : stepUs - dtUs;
+	if(dStep > (stepUs >> STEP_TOLERANCE)) setStep(dtUs);
+
+	// Filtered derivative of error
+	lastDelta = clamp16((fixed_t)e - lastError);
+	lastError = e;
+	if(invStep > 0) {
+		error_t raw = clamp16(mul(lastDelta, invStep));
+		derivative += ((fixed_t)raw - derivative) >> DSHIFT;
+	}
+
+	// Integrate and sum terms
+	integral = constrain(integral + mul(e, kiStep),
+		-integralMax, integralMax);
+	fixed_t u =
+		mul(e, kp) +
+		(integral >> IQ) +
+		mul(derivative, kd);
+
+	// Saturate with back-calculation anti-windup
+	fixed_t uSat = constrain(u, outMin, outMax);
+	bool satNow = (uSat != u);
+	if(satNow && !sat && traceId) {
+		TRACE(Trace::EVENT_PID_SATURATED,
+			traceId | ((u > outMax) ? 0x100 : 0));
+	}
+	sat = satNow;
+	fixed_t back = mul(clamp16(uSat - u), kbStep);
+	if((integral > 0 && back < 0) || (integral < 0 && back > 0)) {
+		fixed_t bled = integral + back;
+		integral = ((bled > 0) == (integral > 0)) ? bled : 0;
+	}
+	return uSat;
+}
+
+//!b Returns true if controller is at steady state.
+//!i Maximum error magnitude
+//!i Maximum error change over last update
+template<uint8_t Q, uint8_t DSHIFT>
+bool FixedPid<Q, DSHIFT>::steadyState(float eMax, float dMax) {
+	return
+		abs(lastError) <= toFixed(eMax) &&
+		abs(lastDelta) <= toFixed(dMax);
+}
+
+//!b Resets integrator and derivative filter.
+template<uint8_t Q, uint8_t DSHIFT>
+void FixedPid<Q, DSHIFT>::reset() {
+	integral = 0;
+	derivative = 0;
+	lastError = 0;
+	lastDelta = 0;
+	begun = false;
+	sat = false;
+	lastUs = Capture::micros();
+}
+
+//!b Changes controller gains with bumpless transfer.
+//!i Proportional gain
+//!i Integral gain
+//!i Derivative gain
+//!d The integrator is shifted so that the output for the last
+//!d error and derivative is the same under the new gains.
+template<uint8_t Q, uint8_t DSHIFT>
+void FixedPid<Q, DSHIFT>::setGains(float kp, float ki, float kd) {
+	fixed_t kpNew = (fixed_t)(kp * 65536.0);
+	fixed_t kdNew = (fixed_t)(kd * 65536.0);
+	integral += (
+		mul(lastError, this->kp - kpNew) +
+		mul(derivative, this->kd - kdNew)) * (1L << IQ);
+	this->kp = kpNew;
+	this->ki = (fixed_t)(ki * 65536.0);
+	this->kd = kdNew;
+	if(autoKb) this->kb = (fixed_t)(trackingGain(kp, ki, kd) * 65536.0);
+	setStep(stepUs);
+}
+
+//!b Sets id logged to the event trace on saturation.
+//!i Controller id (see Trace::pid_t) (0 to disable)
+template<uint8_t Q, uint8_t DSHIFT>
+void FixedPid<Q, DSHIFT>::setTraceId(uint8_t id) {
+	traceId = id;
+}
+
+//!b Returns true if the last output was saturated.
+template<uint8_t Q, uint8_t DSHIFT>
+bool FixedPid<Q, DSHIFT>::saturated() const {
+	return sat;
+}
+
+//!b Returns default back-calculation tracking gain (1/s).
+//!i Proportional gain
+//!i Integral gain
+//!i Derivative gain
+template<uint8_t Q, uint8_t DSHIFT>
+float FixedPid<Q, DSHIFT>::trackingGain(float kp, float ki, float kd) {
+	if(ki == 0 || kp == 0) return ki;
+	else if(kd == 0) return ki / kp;
+	else return sqrt(ki / kd);
+}
+
+//!b Caches the step-dependent gains for a new time step.
+//!i Time step (us) (0 on the first update)
+//!d Runs in float, but only when the step changes by more than
+//!d the tolerance. Steps under 100 us skip the derivative.
+template<uint8_t Q, uint8_t DSHIFT>
+void FixedPid<Q, DSHIFT>::setStep(uint32_t dtUs) {
+	stepUs = dtUs;
+	float dt = dtUs * 1e-6;
+	float kiDt = ki * (dt * 16384.0);	// Q16 to Q30
+	float kbDt = kb * (dt * 16384.0);
+	kiStep = (kiDt < 2147483647.0) ? (fixed_t)kiDt : 0x7FFFFFFF;
+	kbStep = (kbDt < 2147483647.0) ? (fixed_t)kbDt : 0x7FFFFFFF;
+	invStep = (dtUs < 100) ? 0 : (fixed_t)(65536.0 / dt);
+}
+
+//!b Converts float to a saturated Q-format error.
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::error_t
+FixedPid<Q, DSHIFT>::toError(float x) {
+	x *= (float)(1L << Q);
+	if(x >= 32767.0) return 32767;
+	if(x <= -32767.0) return -32767;
+	return (error_t)x;
+}
+
+//!b Converts float to Q-format.
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::fixed_t
+FixedPid<Q, DSHIFT>::toFixed(float x) {
+	return (fixed_t)(x * (float)(1L << Q));
+}
+
+//!b Converts Q-format to float.
+template<uint8_t Q, uint8_t DSHIFT>
+float FixedPid<Q, DSHIFT>::toFloat(fixed_t x) {
+	return (float)x * (1.0 / (float)(1L << Q));
+}
+
+//!b Multiplies a 16-bit value by a 32-bit Q16 value.
+//!i Value
+//!i Q16 factor
+//!d Returns the product in the format of the 16-bit value. Both
+//!d halves of the factor are 16 x 16 multiplies, so the result
+//!d matches a 64-bit product shifted by 16 to within 1 LSB.
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::fixed_t
+FixedPid<Q, DSHIFT>::mul(error_t a, fixed_t b) {
+	int16_t hi = (int16_t)(b >> 16);
+	uint16_t lo = (uint16_t)b;
+	return (fixed_t)a * hi + (((fixed_t)a * lo) >> 16);
+}
+
+//!b Saturates a Q-format value to the 16-bit range.
+template<uint8_t Q, uint8_t DSHIFT>
+typename FixedPid<Q, DSHIFT>::error_t
+FixedPid<Q, DSHIFT>::clamp16(fixed_t x) {
+	if(x > 32767) return 32767;
+	if(x < -32767) return -32767;
+	return (error_t)x;
+}
@@ -0,0 +1,112 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FlameLocator.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "FlameLocator.h"
+#include "Odometer.h"
+#include "PanTilt.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace FlameLocator {
+
+	// Estimation Parameters
+	const int BEARING_THRESHOLD = 900;	// Weakest usable read (ADC)
+	const uint8_t MIN_BEARINGS = 3;
+	const float MIN_DET = 0.25;		// Normal matrix det (spread)
+	const float RANGE_MAX = 3.0;	// From robot (m)
+
+	// Strongest Reading of Current Pass
+	uint16_t pass = 0;
+	int minRead = 1023;		// (ADC)
+	float minBearing = 0;	// (rad)
+	Vec2 minOrigin;			// (m)
+
+	// Normal Equations (A x = b)
+	float axx = 0, axy = 0, ayy = 0;
+	Vec2 b;
+	uint8_t count = 0;
+
+	// Estimate
+	Vec2 flame;		// (m)
+	bool valid = false;
+
+	// Private Function Templates
+	void addBearing(const Vec2&, float);
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Clears all bearings and the estimate.
+//!d Call this method when the flame search starts.
+void FlameLocator::reset() {
+	pass = PanTilt::sweepPasses;
+	minRead = 1023;
+	axx = axy = ayy = 0;
+	b = Vec2();
+	count = 0;
+	valid = false;
+}
+
+//!b Updates the current sweep pass with a flame sensor reading.
+//!i Flame sensor reading (ADC) (lower is stronger)
+//!d Call this method every loop while PanTilt is sweeping.
+void FlameLocator::loop(int read) {
+	if(PanTilt::sweepPasses != pass) {
+		if(minRead < BEARING_THRESHOLD) {
+			addBearing(minOrigin, minBearing);
+		}
+		pass = PanTilt::sweepPasses;
+		minRead = 1023;
+	}
+	if(read < minRead) {
+		minRead = read;
+		minBearing = Odometer::heading + PanTilt::pan;
+		minOrigin = Odometer::position;
+	}
+}
+
+//!b Adds a bearing line and re-solves for the flame position.
+//!i Origin of bearing (m)
+//!i Bearing (rad) (direction (sin, cos) as for robot heading)
+void FlameLocator::addBearing(const Vec2& p, float theta) {
+
+	// Accumulate n n' and n n' p for line normal n
+	Vec2 n(cos(theta), -sin(theta));
+	float c = dot(n, p);
+	axx += n.x * n.x;
+	axy += n.x * n.y;
+	ayy += n.y * n.y;
+	b += n * c;
+	count++;
+
+	// Solve if bearings are numerous and spread enough
+	Mat2 A(axx, axy, axy, ayy);
+	valid = false;
+	if(count >= MIN_BEARINGS && A.det() >= MIN_DET) {
+		flame = A.inverse() * b;
+		valid = norm(flame - Odometer::position) <= RANGE_MAX;
+	}
+}
+
+//!b Returns true if a valid flame estimate exists.
+bool FlameLocator::hasEstimate() {
+	return valid;
+}
+
+//!b Returns estimated flame position (x,y) (m).
+Vec2 FlameLocator::estimate() {
+	return flame;
+}
+
+//!b Returns number of bearings taken.
+uint8_t FlameLocator::bearings() {
+	return count;
+}
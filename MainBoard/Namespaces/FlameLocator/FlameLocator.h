@@ -0,0 +1,34 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FlameLocator.h
+//!b Namespace for final project flame triangulation.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d While the robot searches, the flame sensor reading is
+//!d tracked over each pan sweep pass. If the strongest reading
+//!d of a pass is above a weak threshold, the bearing to it (robot
+//!d heading plus pan angle) is taken from the robot's position at
+//!d that sample. The bearing lines are intersected by least
+//!d squares, with the 2x2 normal equations accumulated as each
+//!d bearing arrives, so no bearings are stored. An estimate is
+//!d valid once there are enough bearings from different enough
+//!d directions and it lies within range of the robot.
+
+#pragma once
+#include "Arduino.h"
+#include "Linear.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace FlameLocator {
+	void reset();
+	void loop(int);
+
+	bool hasEstimate();
+	Vec2 estimate();
+	uint8_t bearings();
+}
@@ -0,0 +1,142 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FlameSensor.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "FlameSensor.h"
+#include "Capture.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace FlameSensor {
+
+	// Arduino Pin Settings
+	const uint8_t PIN_FLAME_SENSOR = A0;
+
+	// Sampling
+	const uint32_t SAMPLE_PERIOD = 10000;	// 100 Hz (us)
+	const uint8_t BUFFER_SIZE = 64;			// 0.64 s window
+	uint16_t buffer[BUFFER_SIZE];			// (ADC)
+	uint8_t head = 0;
+	uint8_t count = 0;		// Samples since clear
+	uint16_t missedCount = 0;	// Samples missed since clear
+	uint32_t nextSample = 0;	// (us)
+
+	// Flicker Detection
+	// Goertzel bins k = 3 to 8 (4.7 to 12.5 Hz), with
+	// coefficients 2 cos(2 pi k / BUFFER_SIZE). White noise puts
+	// about a fifth of its energy in these bins.
+	const uint8_t NUM_BINS = 6;
+	const float BIN_COEFF[NUM_BINS] = {
+		1.913881, 1.847759, 1.763843, 1.662939, 1.546021, 1.414214 };
+	const float FLICKER_MIN = 3.0;		// Band amplitude (ADC)
+	const float FLICKER_FRACTION = 0.55;	// Band share of AC energy
+	const float FLICKER_HALF_RATIO = 3.0;	// Window half energy ratio
+	const int LEVEL_MAX = 900;			// Mean reading (ADC)
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Initializes flame sensor pin and sampling.
+//!d Call this method in the main setup function.
+void FlameSensor::setup() {
+	pinMode(PIN_FLAME_SENSOR, INPUT);
+	clear();
+	nextSample = Capture::micros();
+}
+
+//!b Takes a buffer sample when one is due.
+//!d Call this method in the main loop function. If the loop falls
+//!d more than a period behind, the missed samples are counted and
+//!d the window is discarded, as its bins would no longer sit on
+//!d the flicker frequencies. Sampling restarts from now.
+void FlameSensor::loop() {
+	uint32_t now = Capture::micros();
+	if((int32_t)(now - nextSample) < 0) return;
+	nextSample += SAMPLE_PERIOD;
+	if((int32_t)(now - nextSample) >= 0) {
+		uint32_t n = (now - nextSample) / SAMPLE_PERIOD + 1;
+		missedCount = (missedCount + n > 0xFFFF) ?
+			0xFFFF : missedCount + n;
+		nextSample = now + SAMPLE_PERIOD;
+		head = 0;
+		count = 0;
+	}
+	buffer[head] = read();
+	head = (head + 1) % BUFFER_SIZE;
+	if(count < BUFFER_SIZE) count++;
+}
+
+//!b Returns a direct flame sensor reading (ADC).
+int FlameSensor::read() {
+	return Capture::analog(PIN_FLAME_SENSOR);
+}
+
+//!b Empties the sample buffer.
+//!d Call this method when the sensor starts looking at a new spot.
+void FlameSensor::clear() {
+	head = 0;
+	count = 0;
+	missedCount = 0;
+}
+
+//!b Returns true if the buffer has filled since it was cleared.
+bool FlameSensor::full() {
+	return count == BUFFER_SIZE;
+}
+
+//!b Returns number of samples missed since the buffer was cleared.
+uint16_t FlameSensor::missed() {
+	return missedCount;
+}
+
+//!b Returns true if the buffered samples show a flickering flame.
+//!d Requires a full buffer, a mean reading strong enough to be a
+//!d flame, and flicker band energy that is both large enough and
+//!d a large enough share of the signal's AC energy. The AC energy
+//!d must also be spread over the window, as a flame keeps
+//!d flickering whereas a reflection ringing as the robot rocks to
+//!d a stop dies away. Halves are taken from the oldest sample.
+bool FlameSensor::flickering() {
+	if(!full()) return false;
+
+	// Mean and AC energy
+	uint32_t sum = 0;
+	for(uint8_t n = 0; n < BUFFER_SIZE; n++) sum += buffer[n];
+	float mean = (float)sum / BUFFER_SIZE;
+	if(mean > LEVEL_MAX) return false;
+	float early = 0, late = 0;
+	for(uint8_t n = 0; n < BUFFER_SIZE; n++) {
+		float x = buffer[(head + n) % BUFFER_SIZE] - mean;
+		if(n < BUFFER_SIZE / 2) early += x * x;
+		else late += x * x;
+	}
+	float energy = early + late;
+	if(energy <= 0) return false;
+	if(early > FLICKER_HALF_RATIO * late) return false;
+	if(late > FLICKER_HALF_RATIO * early) return false;
+
+	// Goertzel power summed over flicker bins
+	float power = 0;
+	for(uint8_t b = 0; b < NUM_BINS; b++) {
+		float s1 = 0, s2 = 0;
+		for(uint8_t n = 0; n < BUFFER_SIZE; n++) {
+			float s0 = (buffer[n] - mean) + BIN_COEFF[b] * s1 - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+		power += s1 * s1 + s2 * s2 - BIN_COEFF[b] * s1 * s2;
+	}
+
+	// A sinusoid of amplitude A at a bin has power (A N / 2)^2
+	// and AC energy A^2 N / 2.
+	float amplitude = 2.0 * sqrt(power) / BUFFER_SIZE;
+	float fraction = 2.0 * power / (BUFFER_SIZE * energy);
+	return amplitude >= FLICKER_MIN && fraction >= FLICKER_FRACTION;
+}
@@ -0,0 +1,39 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t FlameSensor.h
+//!b Namespace for final project flame sensor and flicker detector.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d The IR flame sensor reads lower for a stronger flame. Besides
+//!d direct reads, the sensor is sampled at a fixed rate into a
+//!d ring buffer. A candle flickers at a few Hz, whereas sunlight
+//!d and IR reflections are steady, so flickering() checks the
+//!d buffer for energy in the flicker band with the Goertzel
+//!d algorithm before a flame is believed. Goertzel magnitudes at
+//!d whole bins do not depend on where the window starts, so the
+//!d ring buffer is used in place without reordering. A window with
+//!d missed samples is discarded. A steady reading is never taken
+//!d as a flame, since nothing in a steady signal tells a candle
+//!d from a reflection. Host/FlameSensorReport.cpp measures the
+//!d detection rate, latency, and false positive rate on synthetic
+//!d traces.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace FlameSensor {
+	void setup();
+	void loop();
+	int read();
+
+	void clear();
+	bool full();
+	uint16_t missed();
+	bool flickering();
+}
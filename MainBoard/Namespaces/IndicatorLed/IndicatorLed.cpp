@@ -6,6 +6,7 @@
 //!a Dan Oates (RBE-2002 B17 Team 10)
 
 #include "IndicatorLed.h"
+#include "LoopTimer.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -14,6 +15,24 @@
 namespace IndicatorLed {
 	const uint8_t PIN_LED = 13;
 	Led led(PIN_LED);
+
+	// Warning Blink
+	const float WARN_HALF_PERIOD = 0.25;	// (s)
+	bool warning = false;
+	bool lit = true;
+	LoopTimer blinkTimer;
+
+	// Fault Code Flashing
+	const float FLASH_ON_TIME = 0.1;	// (s)
+	const float FLASH_OFF_TIME = 0.25;	// (s)
+	const float FLASH_PAUSE_TIME = 1.0;	// (s)
+	bool faulted = false;
+	uint8_t code = 0;	// Flashes per pattern
+	uint8_t phase = 0;	// Flash on/off phase in pattern
+
+	// Private Function Templates
+	void setLit(bool);
+	float phaseTime();
 }
 
 //**************************************************************/
@@ -26,13 +45,65 @@ void IndicatorLed::setup() {
 	led.setup();
 }
 
-//!b Flashes LED n times in a loop forever.
-void IndicatorLed::flash(uint8_t n) {
-	while(1) {
-		for(uint8_t i=1; i<=n; i++) {
-			led.on(); delay(100);
-			led.off(); delay(250);
+//!b Flashes fault code or blinks LED if a warning is set.
+//!d Call this method in the main loop function.
+void IndicatorLed::loop() {
+	if(faulted) {
+		if(blinkTimer.hasElapsed(phaseTime())) {
+			blinkTimer.tic();
+			phase = (phase + 1) % (2 * code + 1);
+			setLit(phase < 2 * code && phase % 2 == 0);
 		}
-		delay(1000);
+	} else if(warning && blinkTimer.hasElapsed(WARN_HALF_PERIOD)) {
+		blinkTimer.tic();
+		setLit(!lit);
+	}
+}
+
+//!b Sets or clears warning blink.
+//!d LED is left on when the warning clears.
+void IndicatorLed::warn(bool w) {
+	if(faulted) {
+		warning = w;
+		return;
 	}
+	if(w && !warning) {
+		blinkTimer.tic();
+	} else if(!w && warning) {
+		setLit(true);
+	}
+	warning = w;
+}
+
+//!b Starts flashing a fault code.
+//!i Number of flashes per pattern
+void IndicatorLed::fault(uint8_t n) {
+	faulted = true;
+	code = n;
+	phase = 0;
+	blinkTimer.tic();
+	setLit(n > 0);
+}
+
+//!b Stops flashing fault code and leaves LED on.
+void IndicatorLed::clearFault() {
+	faulted = false;
+	blinkTimer.tic();
+	setLit(true);
+}
+
+//!b Turns LED on or off.
+void IndicatorLed::setLit(bool on) {
+	lit = on;
+	if(lit) led.on();
+	else led.off();
+}
+
+//!b Returns duration (s) of current fault flash phase.
+//!d Even phases are flashes, odd phases are gaps, and the last
+//!d phase is the pause between patterns.
+float IndicatorLed::phaseTime() {
+	if(phase == 2 * code) return FLASH_PAUSE_TIME;
+	else if(phase % 2 == 0) return FLASH_ON_TIME;
+	else return FLASH_OFF_TIME;
 }
@@ -7,7 +7,10 @@
 //!a Dan Oates (RBE-2002 B17 Team 10)
 
 //!d The indicator LED is used to indicate robot state and
-//!d errors without a complex external interface.
+//!d errors without a complex external interface. It is lit
+//!d while the robot runs, blinks (without blocking) as a warning,
+//!d and flashes a fault code (n flashes then a pause) while the
+//!d robot is in fault mode. None of these block.
 
 #pragma once
 #include "Led.h"
@@ -20,5 +23,8 @@ namespace IndicatorLed {
 	extern Led led;
 
 	void setup();
-	void flash(uint8_t);
+	void loop();
+	void warn(bool);
+	void fault(uint8_t);
+	void clearFault();
 }
@@ -0,0 +1,107 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Linear.h
+//!b Fixed-size vector and matrix types for the robot.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d These replace the dynamically sized LinearAtmel Vec and Mat
+//!d classes. Sizes are fixed at compile time, so the types live
+//!d in static memory or on the stack (no heap) and copy by value.
+//!d All operations are inline and reduce to scalar arithmetic.
+//!d Components are named (x, y, z) rather than 1-based indices.
+//!d The sizes below are checked at compile time, so a type can
+//!d not grow hidden storage. SRAM use of the whole firmware is
+//!d measured on the robot by Memory (Matlab GETMEMORY).
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// STRUCT DECLARATIONS
+//**************************************************************/
+
+// 2D vector (x, y)
+struct Vec2 {
+	float x, y;
+
+	Vec2() : x(0), y(0) {}
+	Vec2(float x, float y) : x(x), y(y) {}
+
+	Vec2 operator+(const Vec2& v) const { return Vec2(x + v.x, y + v.y); }
+	Vec2 operator-(const Vec2& v) const { return Vec2(x - v.x, y - v.y); }
+	Vec2 operator*(float k) const { return Vec2(k * x, k * y); }
+	Vec2& operator+=(const Vec2& v) { x += v.x; y += v.y; return *this; }
+	Vec2& operator-=(const Vec2& v) { x -= v.x; y -= v.y; return *this; }
+};
+
+// 3D vector (x, y, z)
+struct Vec3 {
+	float x, y, z;
+
+	Vec3() : x(0), y(0), z(0) {}
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+	Vec3 operator+(const Vec3& v) const {
+		return Vec3(x + v.x, y + v.y, z + v.z);
+	}
+	Vec3 operator-(const Vec3& v) const {
+		return Vec3(x - v.x, y - v.y, z - v.z);
+	}
+	Vec3 operator*(float k) const { return Vec3(k * x, k * y, k * z); }
+};
+
+// 2x2 matrix [a b; c d]
+struct Mat2 {
+	float a, b, c, d;
+
+	Mat2() : a(1), b(0), c(0), d(1) {}
+	Mat2(float a, float b, float c, float d) : a(a), b(b), c(c), d(d) {}
+
+	Vec2 operator*(const Vec2& v) const {
+		return Vec2(a * v.x + b * v.y, c * v.x + d * v.y);
+	}
+	Mat2 operator*(const Mat2& m) const {
+		return Mat2(
+			a * m.a + b * m.c, a * m.b + b * m.d,
+			c * m.a + d * m.c, c * m.b + d * m.d);
+	}
+	float det() const { return a * d - b * c; }
+	Mat2 inverse() const {
+		float k = 1.0 / det();
+		return Mat2(k * d, -k * b, -k * c, k * a);
+	}
+};
+
+//**************************************************************/
+// INLINE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Returns dot product of two vectors.
+inline float dot(const Vec2& u, const Vec2& v) {
+	return u.x * v.x + u.y * v.y;
+}
+
+//!b Returns dot product of two vectors.
+inline float dot(const Vec3& u, const Vec3& v) {
+	return u.x * v.x + u.y * v.y + u.z * v.z;
+}
+
+//!b Returns Euclidean norm of a vector.
+inline float norm(const Vec2& v) {
+	return sqrt(dot(v, v));
+}
+
+//!b Returns Euclidean norm of a vector.
+inline float norm(const Vec3& v) {
+	return sqrt(dot(v, v));
+}
+
+//**************************************************************/
+// SIZE CHECKS
+//**************************************************************/
+
+static_assert(sizeof(Vec2) == 2 * sizeof(float), "Vec2 must be 2 floats");
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 must be 3 floats");
+static_assert(sizeof(Mat2) == 4 * sizeof(float), "Mat2 must be 4 floats");
@@ -0,0 +1,78 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t LoopTimer.h
+//!b Class for timing on the captured loop clock.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This class is a drop-in replacement for Timer which reads
+//!d the loop start time latched by Capture rather than micros,
+//!d so every timeout and period in the firmware replays exactly
+//!d from a capture. Time does not advance within a loop.
+
+#pragma once
+#include "Arduino.h"
+#include "Capture.h"
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+class LoopTimer {
+public:
+	LoopTimer();
+
+	void tic();
+	float toc() const;
+	bool hasElapsed(float) const;
+	void pause();
+	void resume();
+
+private:
+	uint32_t start;
+	uint32_t pausedAt;
+	bool paused;
+};
+
+//**************************************************************/
+// CLASS FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Constructs timer started at the current loop time.
+inline LoopTimer::LoopTimer() :
+	start(Capture::micros()), pausedAt(0), paused(false) {}
+
+//!b Restarts timer.
+inline void LoopTimer::tic() {
+	start = Capture::micros();
+	paused = false;
+}
+
+//!b Returns time since last tic excluding pauses (s).
+inline float LoopTimer::toc() const {
+	uint32_t end = paused ? pausedAt : Capture::micros();
+	return (end - start) * 1e-6;
+}
+
+//!b Returns true if given time has elapsed since last tic.
+//!i Time (s)
+inline bool LoopTimer::hasElapsed(float t) const {
+	return toc() >= t;
+}
+
+//!b Stops timer from counting.
+inline void LoopTimer::pause() {
+	if(!paused) {
+		pausedAt = Capture::micros();
+		paused = true;
+	}
+}
+
+//!b Resumes counting after a pause.
+inline void LoopTimer::resume() {
+	if(paused) {
+		start += Capture::micros() - pausedAt;
+		paused = false;
+	}
+}
@@ -8,8 +8,16 @@
 #include "MatlabComms.h"
 #include "FireBot.h"
 #include "WallFollower.h"
+#include "DriveSystem.h"
 #include "Odometer.h"
 #include "Sonar.h"
+#include "Battery.h"
+#include "Mission.h"
+#include "Capture.h"
+#include "LoopTimer.h"
+#include "Trace.h"
+#include "Memory.h"
+#include "Telemetry.h"
 #include "Hc06.h"
 #include "BinarySerial.h"
 
@@ -26,17 +34,34 @@ namespace MatlabComms {
 		BAUD = 57600;
 	const float
 		TIMEOUT = 1.0; // (s)
+	const uint8_t
+		GAINS_BYTES = 13; // SETGAINS data (pid, kp, ki, kd)
 
 	// Message Type Byte Definitions
 	const byte BYTE_CONNECT = 0x01;
 	const byte BYTE_GETDATA = 0x02;
 	const byte BYTE_DISCONNECT = 0x03;
+	const byte BYTE_SETGAINS = 0x04;
+	const byte BYTE_GETMISSION = 0x05;
+	const byte BYTE_GETTIMING = 0x06;
+	const byte BYTE_GETTRACE = 0x07;
+	const byte BYTE_GETMEMORY = 0x08;
+	const byte BYTE_GETFAULT = 0x09;
+	const byte BYTE_CLEARFAULT = 0x0A;
 
 	// Communication Interface
 	BinarySerial bSerial(*PORT, BAUD);
 	Hc06 hc06(*PORT, BAUD);
-	Timer timer;
+	LoopTimer timer;
 	bool disconnected = false;
+	bool resumed = false;	// No message since checkpoint resume
+	bool gainsPending = false;	// SETGAINS waiting for its data
+	LoopTimer gainsTimer;
+
+	// Private Function Templates
+	void readGains();
+	void writeTiming(float, uint16_t);
+	void writeTrace();
 }
 
 //**************************************************************/
@@ -49,22 +74,27 @@ namespace MatlabComms {
 bool MatlabComms::setup() {
 	if(hc06.setup()) {
 		bSerial.setup();
+		bSerial.flush();
 		return true;
 	} else
 		return false;
 }
 
-//!b Waits for begin message from Matlab.
-//!d Returns false if Matlab sent wrong connect byte.
-bool MatlabComms::waitForBegin() {
-	bSerial.flush();
-	bSerial.wait();
-	if(bSerial.readByte() == BYTE_CONNECT) {
+//!b Checks for begin message from Matlab without blocking.
+//!d Return codes:
+//!d - 0: No message yet
+//!d - 1: Begin message received and acknowledged
+//!d - 2: Matlab sent wrong connect byte
+uint8_t MatlabComms::pollBegin() {
+	if(!Capture::available(bSerial.available())) {
+		return 0;
+	}
+	if(Capture::serialByte(bSerial.readByte()) == BYTE_CONNECT) {
 		bSerial.writeByte(BYTE_CONNECT);
 		timer.tic();
-		return true;
+		return 1;
 	} else
-		return false;
+		return 2;
 }
 
 //!b Runs one iteration of Matlab communication loop.
@@ -73,28 +103,154 @@ bool MatlabComms::waitForBegin() {
 //!d - 0: Complete success
 //!d - 1: No message received within timeout
 //!d - 2: Invalid message type byte received
+//!d Never blocks: a message whose data has not all arrived is
+//!d finished on a later loop.
 uint8_t MatlabComms::loop() {
-	if(bSerial.available()) {
-		while(bSerial.available()) {
+
+	// Finish gains update once its data arrives
+	if(gainsPending) {
+		if(Capture::available(bSerial.available()) < GAINS_BYTES) {
+			if(!gainsTimer.hasElapsed(TIMEOUT)) return 0;
+			gainsPending = false;
+			return 1;
+		}
+		gainsPending = false;
+		readGains();
+	}
+
+	if(Capture::available(bSerial.available())) {
+		while(Capture::available(bSerial.available())) {
 
 			// Check message type byte
-			switch(bSerial.readByte()) {
+			byte type = Capture::serialByte(bSerial.readByte());
+			TRACE(Trace::EVENT_MATLAB, type);
+			switch(type) {
 
 				// Robot data request
-				case BYTE_GETDATA:
+				// Sends the latest telemetry frame, ending with its
+				// cycle number (uint32, little-endian).
+				case BYTE_GETDATA: {
+					Telemetry::Frame f;
+					Telemetry::read(f);
 					bSerial.writeByte(BYTE_GETDATA);
+					bSerial.writeByte(f.fireBotState);
+					bSerial.writeByte(f.wallState);
+					bSerial.writeFloat(f.position.x);
+					bSerial.writeFloat(f.position.y);
+					bSerial.writeFloat(f.heading);
+					bSerial.writeFloat(f.distF);
+					bSerial.writeFloat(f.distB);
+					bSerial.writeFloat(f.distL);
+					bSerial.writeFloat(f.distR);
+					bSerial.writeFloat(f.flamePos.x);
+					bSerial.writeFloat(f.flamePos.y);
+					bSerial.writeFloat(f.flamePos.z);
+					bSerial.writeFloat(f.battery);
+					for(uint8_t i = 0; i < 4; i++) {
+						bSerial.writeByte(f.cycle >> (8 * i));
+					}
+					break;
+				}
+
+				// Controller gains update
+				case BYTE_SETGAINS:
+					if(Capture::available(bSerial.available()) <
+						GAINS_BYTES)
+					{
+						gainsPending = true;
+						gainsTimer.tic();
+						timer.tic();
+						resumed = false;
+						return 0;
+					}
+					readGains();
+					break;
+
+				// Mission statistics request
+				case BYTE_GETMISSION:
+					bSerial.writeByte(BYTE_GETMISSION);
 					bSerial.writeByte(FireBot::getState());
-					bSerial.writeByte(WallFollower::getState());
-					bSerial.writeFloat(Odometer::position(1));
-					bSerial.writeFloat(Odometer::position(2));
-					bSerial.writeFloat(Odometer::heading);
-					bSerial.writeFloat(Sonar::distF);
-					bSerial.writeFloat(Sonar::distB);
-					bSerial.writeFloat(Sonar::distL);
-					bSerial.writeFloat(Sonar::distR);
-					bSerial.writeFloat(FireBot::flamePos(1));
-					bSerial.writeFloat(FireBot::flamePos(2));
-					bSerial.writeFloat(FireBot::flamePos(3));
+					bSerial.writeByte(Mission::faultCode);
+					bSerial.writeFloat(Mission::time(
+						Mission::EVENT_FLAME_FOUND));
+					bSerial.writeFloat(Mission::time(
+						Mission::EVENT_EXTINGUISHED));
+					bSerial.writeFloat(Mission::time(
+						Mission::EVENT_AT_HOME));
+					bSerial.writeFloat(Mission::homeError);
+					bSerial.writeFloat(FireBot::flamePos.x);
+					bSerial.writeFloat(FireBot::flamePos.y);
+					bSerial.writeFloat(FireBot::flamePos.z);
+					bSerial.writeFloat(Mission::bootTime);
+					bSerial.writeByte(Mission::resumes);
+					break;
+
+				// State timing profile request
+				// Sends states 1 to n of FireBot then WallFollower.
+				case BYTE_GETTIMING: {
+					bSerial.writeByte(BYTE_GETTIMING);
+					uint8_t n = FireBot::numStates() - 1;
+					bSerial.writeByte(n);
+					for(uint8_t s = 1; s <= n; s++) {
+						writeTiming(
+							FireBot::dwellTime(s),
+							FireBot::entries(s));
+					}
+					n = WallFollower::numStates() - 1;
+					bSerial.writeByte(n);
+					for(uint8_t s = 1; s <= n; s++) {
+						writeTiming(
+							WallFollower::dwellTime(s),
+							WallFollower::entries(s));
+					}
+					break;
+				}
+
+				// Event trace dump request
+				case BYTE_GETTRACE:
+					bSerial.writeByte(BYTE_GETTRACE);
+					writeTrace();
+					break;
+
+				// SRAM usage request (bytes)
+				case BYTE_GETMEMORY:
+					Memory::scan();
+					bSerial.writeByte(BYTE_GETMEMORY);
+					bSerial.writeFloat(Memory::staticBytes());
+					bSerial.writeFloat(Memory::heapBytes());
+					bSerial.writeFloat(Memory::stackBytes());
+					bSerial.writeFloat(Memory::marginBytes());
+					break;
+
+				// Fault snapshot request
+				// Code is 0xFF if robot is not in fault mode.
+				case BYTE_GETFAULT: {
+					const FireBot::Fault& f = FireBot::fault;
+					bSerial.writeByte(BYTE_GETFAULT);
+					bSerial.writeByte(FireBot::inFault() ? f.code : 0xFF);
+					bSerial.writeByte(f.state);
+					bSerial.writeByte(f.wallState);
+					bSerial.writeFloat(f.time);
+					bSerial.writeFloat(f.position.x);
+					bSerial.writeFloat(f.position.y);
+					bSerial.writeFloat(f.heading);
+					bSerial.writeFloat(f.distF);
+					bSerial.writeFloat(f.distB);
+					bSerial.writeFloat(f.distL);
+					bSerial.writeFloat(f.distR);
+					bSerial.writeFloat(f.battery);
+					break;
+				}
+
+				// Clear fault and resume
+				case BYTE_CLEARFAULT:
+					bSerial.writeByte(BYTE_CLEARFAULT);
+					bSerial.writeByte(FireBot::clearFault() ? 1 : 0);
+					break;
+
+				// Reconnect after a disconnect
+				case BYTE_CONNECT:
+					bSerial.writeByte(BYTE_CONNECT);
 					break;
 
 				// Disconnect message
@@ -108,9 +264,71 @@ uint8_t MatlabComms::loop() {
 			}
 		}
 		timer.tic();
+		resumed = false;
 	} else {
-		if(timer.hasElapsed(TIMEOUT))
+		if(!resumed && timer.hasElapsed(TIMEOUT))
 			return 1;
 	}
 	return 0;
 }
+
+//!b Continues communication after a checkpoint resume.
+//!d Matlab may have dropped the link during the reset, so the
+//!d message timeout is not enforced until it talks again.
+void MatlabComms::resume() {
+	resumed = true;
+	timer.tic();
+}
+
+//!b Reads a controller gains update and acknowledges it.
+//!d Call only once all of its data has arrived.
+void MatlabComms::readGains() {
+	uint8_t pid = Capture::serialByte(bSerial.readByte());
+	float kp = Capture::serialFloat(bSerial.readFloat());
+	float ki = Capture::serialFloat(bSerial.readFloat());
+	float kd = Capture::serialFloat(bSerial.readFloat());
+	bool ok =
+		DriveSystem::setGains(pid, kp, ki, kd) ||
+		WallFollower::setGains(pid, kp, ki, kd);
+	bSerial.writeByte(BYTE_SETGAINS);
+	bSerial.writeByte(ok ? 1 : 0);
+}
+
+//!b Writes timing of one state to Matlab.
+//!i Cumulative dwell time (s)
+//!i Entry count (sent high byte first)
+void MatlabComms::writeTiming(float dwell, uint16_t entries) {
+	bSerial.writeFloat(dwell);
+	bSerial.writeByte(entries >> 8);
+	bSerial.writeByte(entries & 0xFF);
+}
+
+//!b Writes and removes all records in the event trace.
+//!d Sends the record count, the measured main loop and ISR event
+//!d costs (uint16 CPU cycles each), and the dropped ISR record
+//!d count (uint8). Then sends each record as uint32 time (us),
+//!d uint8 event, and uint16 payload, main loop records first,
+//!d all little-endian. Sends all zeros if tracing is disabled.
+void MatlabComms::writeTrace() {
+#if TRACE_ENABLED
+	uint8_t n = Trace::size();
+	bSerial.writeByte(n);
+	bSerial.writeByte(Trace::loopCycles());
+	bSerial.writeByte(Trace::loopCycles() >> 8);
+	bSerial.writeByte(Trace::isrCycles());
+	bSerial.writeByte(Trace::isrCycles() >> 8);
+	bSerial.writeByte(Trace::dropped());
+	Trace::Record r;
+	for(uint8_t i = 0; i < n && Trace::pop(r); i++) {
+		bSerial.writeByte(r.time);
+		bSerial.writeByte(r.time >> 8);
+		bSerial.writeByte(r.time >> 16);
+		bSerial.writeByte(r.time >> 24);
+		bSerial.writeByte(r.event);
+		bSerial.writeByte(r.payload);
+		bSerial.writeByte(r.payload >> 8);
+	}
+#else
+	for(uint8_t i = 0; i < 6; i++) bSerial.writeByte(0);
+#endif
+}
\ No newline at end of file
@@ -22,6 +22,7 @@ namespace MatlabComms {
 	extern bool disconnected;
 
 	bool setup();
-	bool waitForBegin();
+	uint8_t pollBegin();
 	uint8_t loop();
+	void resume();
 }
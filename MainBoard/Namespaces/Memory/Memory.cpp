@@ -0,0 +1,120 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Memory.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Memory.h"
+#include "IndicatorLed.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+// Linker and avr-libc memory symbols
+extern "C" {
+	extern uint8_t __data_start;	// Start of static data
+	extern uint8_t _end;			// End of static data
+	extern uint8_t* __brkval;		// Top of heap (0 if unused)
+}
+
+namespace Memory {
+
+	// Paint Settings
+	const uint8_t CANARY = 0xC5;
+	const uint8_t CLEAN_RUN = 32;	// Untouched bytes ending a scan
+
+	// Warning Threshold (bytes)
+	const uint16_t MARGIN_WARN = 512;
+
+	// Lowest address written by the stack
+	uint8_t* stackLow = (uint8_t*)RAMEND;
+
+	// Private Function Templates
+	uint8_t* heapEnd();
+	void paint() __attribute__((naked, used, section(".init1")));
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Paints free SRAM from end of static data to top of stack.
+//!d Runs from the .init1 section before the zero register and
+//!d stack pointer are set up, so it is written in assembly. The
+//!d canary byte must match CANARY. Do not call this method.
+void Memory::paint() {
+	asm volatile(
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, 0xC5\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n");
+}
+
+//!b Finds the stack high-water mark so far.
+//!d Call this method in the main setup function.
+void Memory::setup() {
+	scan();
+}
+
+//!b Updates the stack high-water mark.
+//!d Scans down from the current mark until a run of CLEAN_RUN
+//!d untouched bytes is found, so growth that left some bytes
+//!d below the mark unwritten is still followed. Without growth
+//!d only the run itself is read. Call this method in the main
+//!d loop function.
+void Memory::loop() {
+	uint8_t* end = heapEnd();
+	uint8_t run = 0;
+	uint8_t* p = stackLow;
+	while(p > end && run < CLEAN_RUN) {
+		p--;
+		if(*p == CANARY) {
+			run++;
+		} else {
+			stackLow = p;
+			run = 0;
+		}
+	}
+	IndicatorLed::warn(marginBytes() < MARGIN_WARN);
+}
+
+//!b Rescans all free SRAM for the stack high-water mark.
+//!d Finds stack use that skipped over unwritten bytes.
+void Memory::scan() {
+	uint8_t* p = heapEnd();
+	while(p < stackLow && *p == CANARY) p++;
+	stackLow = p;
+}
+
+//!b Returns end of the heap (or static data if heap is unused).
+uint8_t* Memory::heapEnd() {
+	return __brkval ? __brkval : &_end;
+}
+
+//!b Returns bytes used by static data (.data and .bss).
+uint16_t Memory::staticBytes() {
+	return &_end - &__data_start;
+}
+
+//!b Returns bytes used by the heap.
+uint16_t Memory::heapBytes() {
+	return heapEnd() - &_end;
+}
+
+//!b Returns maximum bytes used by the stack since boot.
+uint16_t Memory::stackBytes() {
+	return (uint8_t*)RAMEND - stackLow + 1;
+}
+
+//!b Returns bytes never touched between the heap and stack.
+uint16_t Memory::marginBytes() {
+	return stackLow - heapEnd();
+}
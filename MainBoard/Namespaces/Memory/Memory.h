@@ -0,0 +1,35 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Memory.h
+//!b Namespace for final project SRAM usage monitor.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d The free SRAM between the heap and the stack is painted with
+//!d a canary byte at boot, before static initialization. The
+//!d stack high-water mark is the lowest address where the paint
+//!d has been overwritten. Each loop scans down from the mark
+//!d until it finds a run of untouched paint, so the monitor
+//!d costs little but follows growth that skipped a few bytes; a
+//!d full rescan is done when Matlab asks for a report. If the
+//!d untouched margin drops below a threshold the indicator LED
+//!d starts blinking.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Memory {
+	void setup();
+	void loop();
+	void scan();
+
+	uint16_t staticBytes();
+	uint16_t heapBytes();
+	uint16_t stackBytes();
+	uint16_t marginBytes();
+}
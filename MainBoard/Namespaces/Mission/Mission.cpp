@@ -0,0 +1,93 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Mission.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Mission.h"
+#include "Odometer.h"
+#include "LoopTimer.h"
+#include "Capture.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Mission {
+
+	// Milestone Times (s) (negative if not reached)
+	float eventTimes[NUM_EVENTS];
+	LoopTimer timer;
+	float timeOffset = 0;	// Mission time before last reset (s)
+
+	// Mission Outcome
+	float bootTime = 0;		// Reset to mission start (s)
+	float homeError = 0;	// Distance from home at stop (m)
+	uint8_t faultCode = 0;	// 0 if no fault
+	uint8_t resumes = 0;	// Checkpoint resumes
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Starts mission clock and clears milestones.
+//!d Call this method when the mission begins. Also records
+//!d the boot time since reset.
+void Mission::start() {
+	for(uint8_t i = 0; i < NUM_EVENTS; i++) {
+		eventTimes[i] = -1;
+	}
+	homeError = 0;
+	faultCode = 0;
+	resumes = 0;
+	bootTime = Capture::millis() * 0.001;
+	timeOffset = 0;
+	timer.tic();
+}
+
+//!b Continues mission clock and milestones from a checkpoint.
+//!i Mission time at checkpoint (s)
+//!i Milestone times (s) (NUM_EVENTS)
+//!i Fault code
+//!i Number of resumes including this one
+//!d Boot time is set to the time taken to resume.
+void Mission::resume(float t, const float* times,
+	uint8_t fault, uint8_t n)
+{
+	for(uint8_t i = 0; i < NUM_EVENTS; i++) {
+		eventTimes[i] = times[i];
+	}
+	faultCode = fault;
+	resumes = n;
+	bootTime = Capture::millis() * 0.001;
+	timeOffset = t;
+	timer.tic();
+}
+
+//!b Records time of a mission milestone.
+//!d Arriving home also records the distance from home.
+void Mission::mark(event_t e) {
+	eventTimes[e] = elapsed();
+	if(e == EVENT_AT_HOME) {
+		homeError = norm(Odometer::position);
+	}
+}
+
+//!b Records the fault code the mission failed with.
+void Mission::fail(uint8_t code) {
+	faultCode = code;
+}
+
+//!b Returns time (s) of a milestone from mission start.
+//!d Returns -1 if the milestone has not been reached.
+float Mission::time(event_t e) {
+	return eventTimes[e];
+}
+
+
+//!b Returns time (s) since mission start.
+float Mission::elapsed() {
+	return timer.toc() + timeOffset;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Mission.h
+//!b Namespace for final project mission statistics.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This namespace records when the robot reaches each mission
+//!d milestone (flame found, flame out, home), how far from home
+//!d it stopped, how long it took to boot, any fault code, and
+//!d how many times it resumed from a checkpoint after a reset.
+//!d Matlab reads these after a run and logs them so runs can be
+//!d compared across firmware revisions.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Mission {
+	enum event_t {
+		EVENT_FLAME_FOUND,
+		EVENT_EXTINGUISHED,
+		EVENT_AT_HOME,
+		NUM_EVENTS,
+	};
+
+	extern float bootTime;
+	extern float homeError;
+	extern uint8_t faultCode;
+	extern uint8_t resumes;
+
+	void start();
+	void resume(float, const float*, uint8_t, uint8_t);
+	void mark(event_t);
+	void fail(uint8_t);
+	float time(event_t);
+	float elapsed();
+}
@@ -6,6 +6,7 @@
 //!a Dan Oates (RBE-2002 B17 Team 10)
 
 #include "MotorR.h"
+#include "Trace.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -61,11 +62,13 @@ void MotorR::setup() {
 //!b Performs ISR for motor encoder A.
 //!d Do not call this method. It is only used internally.
 void MotorR::interruptA() {
+	TRACE_ISR(Trace::EVENT_ENCODER_R, 0);
 	motor.isrA();
 }
 
 //!b Performs ISR for motor encoder B.
 //!d Do not call this method. It is only used internally.
 void MotorR::interruptB() {
+	TRACE_ISR(Trace::EVENT_ENCODER_R, 1);
 	motor.isrB();
 }
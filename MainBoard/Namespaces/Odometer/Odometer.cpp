@@ -10,7 +10,9 @@
 #include "MotorL.h"
 #include "MotorR.h"
 #include "Bno055.h"
-#include "Timer.h"
+#include "LoopTimer.h"
+#include "Capture.h"
+#include "Trace.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -18,17 +20,19 @@
 
 namespace Odometer {
 
-	// Home Distance Threshold (m)
+	// Home Distance Thresholds (m)
 	const float HOME_DISTANCE_THRESHOLD = 0.3;
+	const float HOME_DISTANCE_FINE = 0.1;	// Once relocalized
 
 	// Position Variables
-	Vec position(2);	// Robot position vector (x,y) (m)
-	Vec deltaPos(2);	// Small change in position (x,y) (m)
-	Mat rotator(2,2);	// Heading rotation matrix
+	Vec2 position;	// Robot position vector (x,y) (m)
 
 	// Velocity Variables
 	float velocity = 0;
-	Timer velocityTimer;
+	float velocityL = 0;	// Left wheel (m/s)
+	float velocityR = 0;	// Right wheel (m/s)
+	float distance = 0;	// Total signed travel (m)
+	LoopTimer velocityTimer;
 
 	// Heading Variables
 	float headingCalibration = 0;
@@ -48,22 +52,67 @@ namespace Odometer {
 //!d Returns true if IMU is properly connected.
 bool Odometer::setup() {
 	if(imu.setup()) {
-		headingCalibration = imu.heading();
+		headingCalibration = Capture::imu(imu.heading());
 		velocityTimer.tic();
 		return true;
 	} else
 		return false;
 }
 
+//!b Re-zeroes heading, position, and distance at current pose.
+//!d Call this once the IMU has settled after power-up.
+void Odometer::zero() {
+	headingCalibration = Capture::imu(imu.heading());
+	heading = 0;
+	lastHeading = 0;
+	position = Vec2();
+	distance = 0;
+}
+
+//!b Restores pose after a reset from a mission checkpoint.
+//!i Position (x,y) (m)
+//!i Distance travelled (m)
+//!i Heading (rad)
+//!d Assumes the robot did not turn during the reset, so heading
+//!d is recalibrated against the current IMU reading whether or
+//!d not the IMU itself was reset.
+void Odometer::resume(const Vec2& pos, float dist, float h) {
+	headingCalibration = Capture::imu(imu.heading()) - h;
+	heading = h;
+	lastHeading = h;
+	position = pos;
+	distance = dist;
+}
+
+//!b Removes a measured error from the heading.
+//!i Heading error (rad) (odometer minus measured)
+//!d The IMU calibration is shifted so the correction persists,
+//!d and the last heading is shifted with it so the next update
+//!d does not see the correction as a turn.
+void Odometer::correctHeading(float error) {
+	headingCalibration += error;
+	heading -= error;
+	lastHeading -= error;
+	TRACE(Trace::EVENT_HEADING_FIX, (int16_t)(error * 1000.0));
+}
+
+//!b Adds a measured correction to the position.
+//!i Position correction (x,y) (m)
+void Odometer::correctPosition(const Vec2& delta) {
+	position += delta;
+}
+
 //!b Performs one odometry iteration.
 //!d Computes:
 //!d - Position (x,y) (m)
 //!d - Heading (rad)
 //!d - Velocity (m/s)
+//!d - Wheel velocities (m/s)
+//!d - Distance travelled (m)
 void Odometer::loop() {
 
 	// Get heading and change in heading
-	heading = imu.heading() - headingCalibration;
+	heading = Capture::imu(imu.heading()) - headingCalibration;
 	float dH = heading - lastHeading;
 	lastHeading = heading;
 
@@ -72,35 +121,37 @@ void Odometer::loop() {
 	float dR = MotorR::motor.encoderAngle();
 	MotorL::motor.resetEncoder();
 	MotorR::motor.resetEncoder();
+	Capture::encoders(dL, dR);
 
-	// Compute velocity
-	float arc = (dL + dR) * RobotDims::halfWheelRadius;
-	velocity = arc / velocityTimer.toc();
+	// Compute velocities
+	float dt = velocityTimer.toc();
 	velocityTimer.tic();
+	float arc = (dL + dR) * RobotDims::halfWheelRadius;
+	velocity = arc / dt;
+	velocityL = dL * RobotDims::wheelRadius / dt;
+	velocityR = dR * RobotDims::wheelRadius / dt;
+	distance += arc;
 
 	// Compute delta position vector
+	Vec2 deltaPos;
 	if(dH == 0) {
-		deltaPos(1) = 0;
-		deltaPos(2) = arc;
+		deltaPos.y = arc;
 	} else {
 		float R = arc / dH;
-		deltaPos(1) = R * (1.0 - cos(dH));
-		deltaPos(2) = R * sin(dH);
+		deltaPos.x = R * (1.0 - cos(dH));
+		deltaPos.y = R * sin(dH);
 	}
 
 	// Rotate and add delta position vector to position
 	float ch = cos(heading);
 	float sh = sin(heading);
-
-	rotator(1,1) = ch;
-	rotator(1,2) = sh;
-	rotator(2,1) = -sh;
-	rotator(2,2) = ch;
-
-	position = position + rotator * deltaPos;
+	Mat2 rotator(ch, sh, -sh, ch);
+	position += rotator * deltaPos;
 }
 
 //!b Returns true if robot is near home (0,0) within a threshold.
-bool Odometer::nearHome() {
-	return norm(position) <= HOME_DISTANCE_THRESHOLD;
+//!i True to use the fine threshold (position relocalized)
+bool Odometer::nearHome(bool fine) {
+	return norm(position) <= (fine ?
+		HOME_DISTANCE_FINE : HOME_DISTANCE_THRESHOLD);
 }
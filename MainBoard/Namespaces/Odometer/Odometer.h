@@ -8,21 +8,31 @@
 
 //!d This namespace uses motor encoders from MotorL and MotorR
 //!d and a Bno055 9-DOF IMU to track the robot's heading and
-//!d position relative to its starting point.
+//!d position relative to its starting point. IMU heading drift
+//!d can be removed with correctHeading() using an external heading
+//!d measurement, such as a fit to a straight wall, and position
+//!d error with correctPosition().
 
 #pragma once
-#include "LinearAtmel.h"
+#include "Linear.h"
 
 //**************************************************************/
 // NAMESPACE DECLARATION
 //**************************************************************/
 
 namespace Odometer {
-	extern Vec position;
+	extern Vec2 position;
 	extern float velocity;
+	extern float velocityL;
+	extern float velocityR;
+	extern float distance;
 	extern float heading;
 
 	bool setup();
 	void loop();
-	bool nearHome();
+	void zero();
+	void resume(const Vec2&, float, float);
+	void correctHeading(float);
+	void correctPosition(const Vec2&);
+	bool nearHome(bool = false);
 }
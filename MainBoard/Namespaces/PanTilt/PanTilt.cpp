@@ -7,6 +7,7 @@
 
 #include "PanTilt.h"
 #include "OpenLoopServo.h"
+#include "Capture.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -29,6 +30,8 @@ namespace PanTilt {
 	const float PAN_VEL = PI/2.0;	// rad/s
 
 	float pan = 0;
+	bool panAimed = false;		// At target as of last loop
+	uint16_t sweepPasses = 0;	// Completed pan sweeps
 	OpenLoopServo panServo(
 		PIN_PAN,
 		SERVO_SIGNAL_MIN,
@@ -48,6 +51,7 @@ namespace PanTilt {
 	const float TILT_VEL = 3.5;		// rad/s
 
 	float tilt = 0;
+	bool tiltAimed = false;		// At target as of last loop
 	OpenLoopServo tiltServo(
 		PIN_TILT,
 		SERVO_SIGNAL_MIN,
@@ -60,6 +64,23 @@ namespace PanTilt {
 		STATE_TILT_UP,
 		STATE_TILT_DOWN,
 	} tiltState;
+
+	// Flame Tracking
+	// Dither points are pan +/- then tilt +/- around the centre.
+	const float DITHER_PAN = 0.05;		// rad
+	const float DITHER_TILT = 0.04;		// rad
+	const float TRACK_STEP = 0.02;		// Centre step (rad)
+	const int TRACK_DEADBAND = 10;		// Reading difference (ADC)
+	const uint8_t TRACK_SAMPLES = 4;	// Readings per point
+	float centrePan = 0;	// rad
+	float centreTilt = 0;	// rad
+	uint8_t ditherPoint = 0;
+	uint8_t samples = 0;
+	int sampleSum = 0;		// (ADC)
+	int ditherRead[4];		// Mean reading per point (ADC)
+
+	// Private Function Templates
+	void aimDither();
 }
 
 //**************************************************************/
@@ -76,20 +97,29 @@ void PanTilt::setup() {
 	// Set up pan state machine
 	panServo.setVelocity(PAN_VEL);
 	panServo.setAngle(PAN_MAX);
+	panAimed = false;
 	panState = STATE_PAN_RIGHT;
 
 	// Set up tilt state machine
 	tiltServo.setVelocity(TILT_VEL);
 	tiltServo.setAngle(TILT_MAX);
+	tiltAimed = false;
 	tiltState = STATE_TILT_UP;
 }
 
 //!b Runs open-loop servo loop functions.
 //!d Also updates pan and tilt variables from servo angles.
-//!d Call this method in the main loop always.
+//!d Call this method in the main loop always. The servo library
+//!d times itself, so the estimates are captured and held for the
+//!d rest of the loop. Setting a new angle clears the aimed flag
+//!d until the next loop.
 void PanTilt::loop() {
 	pan = panServo.loop();
+	panAimed = panServo.atTargetAngle();
+	Capture::servo(1, pan, panAimed);
 	tilt = tiltServo.loop();
+	tiltAimed = tiltServo.atTargetAngle();
+	Capture::servo(2, tilt, tiltAimed);
 }
 
 //!b Iterates through flame finder sweep state machine.
@@ -98,16 +128,20 @@ void PanTilt::sweep() {
 	// Pan state machine
 	switch(panState) {
 		case STATE_PAN_RIGHT:	// Panning right
-			if(panServo.atTargetAngle()) {
+			if(panAimed) {
 				panServo.setAngle(PAN_MIN);
+				panAimed = false;
 				panState = STATE_PAN_LEFT;
+				sweepPasses++;
 			}
 			break;
 
 		case STATE_PAN_LEFT:	// Panning left
-			if(panServo.atTargetAngle()) {
+			if(panAimed) {
 				panServo.setAngle(PAN_MAX);
+				panAimed = false;
 				panState = STATE_PAN_RIGHT;
+				sweepPasses++;
 			}
 			break;
 	}
@@ -115,29 +149,93 @@ void PanTilt::sweep() {
 	// Tilt state machine
 	switch(tiltState) {
 		case STATE_TILT_UP:	// Tilting up
-			if(tiltServo.atTargetAngle()) {
+			if(tiltAimed) {
 				tiltServo.setAngle(TILT_MIN);
+				tiltAimed = false;
 				tiltState = STATE_TILT_DOWN;
 			}
 			break;
 
 		case STATE_TILT_DOWN:	// Tilting down
-			if(tiltServo.atTargetAngle()) {
+			if(tiltAimed) {
 				tiltServo.setAngle(TILT_MAX);
+				tiltAimed = false;
 				tiltState = STATE_TILT_UP;
 			}
 			break;
 	}
 }
 
+//!b Starts flame tracking around the current aim.
+void PanTilt::startTracking() {
+	centrePan = pan;
+	centreTilt = tilt;
+	ditherPoint = 0;
+	samples = 0;
+	sampleSum = 0;
+	aimDither();
+}
+
+//!b Runs one flame tracking iteration.
+//!i Flame sensor reading (ADC) (lower is stronger)
+//!d Call this method every loop while the fan is running. Each
+//!d dither point is sampled once the servos reach it. After all
+//!d four, the centre steps along each axis towards the lower
+//!d reading if the difference is outside the deadband.
+void PanTilt::track(int read) {
+	if(!isAimed()) return;
+	sampleSum += read;
+	if(++samples < TRACK_SAMPLES) return;
+	ditherRead[ditherPoint] = sampleSum / TRACK_SAMPLES;
+	samples = 0;
+	sampleSum = 0;
+	if(++ditherPoint == 4) {
+		ditherPoint = 0;
+		int dp = ditherRead[1] - ditherRead[0];
+		int dt = ditherRead[3] - ditherRead[2];
+		if(dp > TRACK_DEADBAND) centrePan += TRACK_STEP;
+		else if(dp < -TRACK_DEADBAND) centrePan -= TRACK_STEP;
+		if(dt > TRACK_DEADBAND) centreTilt += TRACK_STEP;
+		else if(dt < -TRACK_DEADBAND) centreTilt -= TRACK_STEP;
+		centrePan = constrain(centrePan, PAN_MIN, PAN_MAX);
+		centreTilt = constrain(centreTilt, TILT_MIN, TILT_MAX);
+	}
+	aimDither();
+}
+
+//!b Aims servos at the current dither point.
+//!d Points beyond the servo limits are clamped, so the centre is
+//!d still compared against one side at a limit.
+void PanTilt::aimDither() {
+	float p = centrePan;
+	float t = centreTilt;
+	switch(ditherPoint) {
+		case 0: p += DITHER_PAN; break;
+		case 1: p -= DITHER_PAN; break;
+		case 2: t += DITHER_TILT; break;
+		case 3: t -= DITHER_TILT; break;
+	}
+	panServo.setAngle(constrain(p, PAN_MIN, PAN_MAX));
+	panAimed = false;
+	tiltServo.setAngle(constrain(t, TILT_MIN, TILT_MAX));
+	tiltAimed = false;
+}
+
 //!b Directs pan servo to rotate to given angle (rad).
 void PanTilt::setPan(float p) {
 	panServo.setAngle(p);
+	panAimed = false;
 }
 
 //!b Directs tilt servo to rotate to given angle (rad).
 void PanTilt::setTilt(float t) {
 	tiltServo.setAngle(t);
+	tiltAimed = false;
+}
+
+//!b Stops pan servo at its current angle.
+void PanTilt::stopPan() {
+	panServo.stop();
 }
 
 //!b Stops tilt servo at its current angle.
@@ -147,7 +245,5 @@ void PanTilt::stopTilt() {
 
 //!b Returns true if pan and tilt servos are at target angles.
 bool PanTilt::isAimed() {
-	return
-		panServo.atTargetAngle() &&
-		tiltServo.atTargetAngle();
+	return panAimed && tiltAimed;
 }
@@ -8,7 +8,10 @@
 
 //!d This namespace controls the pan-tilt system, consisting of
 //!d two DS3218 servo motors controlled via an open-loop servo
-//!d control library.
+//!d control library. The number of completed pan sweep passes
+//!d is counted in sweepPasses. While the fan runs, track()
+//!d dithers the aim around a centre and steps the centre towards
+//!d the strongest flame sensor reading.
 
 #pragma once
 #include "Arduino.h"
@@ -25,13 +28,17 @@ namespace PanTilt {
 
 	extern float pan;
 	extern float tilt;
+	extern uint16_t sweepPasses;
 
 	void setup();
 	void loop();
 	void sweep();
+	void startTracking();
+	void track(int);
 
 	void setPan(float);
 	void setTilt(float);
+	void stopPan();
 	void stopTilt();
 
 	bool isAimed();
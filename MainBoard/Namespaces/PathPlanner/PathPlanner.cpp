@@ -0,0 +1,253 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t PathPlanner.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "PathPlanner.h"
+#include "FieldMap.h"
+#include "Odometer.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace PathPlanner {
+
+	// Planner Parameters
+	const uint8_t STEPS_PER_LOOP = 8;	// Cell expansions
+	const uint8_t LOOKAHEAD = 6;		// Waypoint search (cells)
+	const uint8_t COST_KNOWN = 1;		// Vacant or swept cell
+	const uint8_t COST_UNKNOWN = 3;
+	const uint8_t COST_NEAR_WALL = 2;	// Added next to occupied
+	const uint8_t COST_MAX = 0xFF;		// Unvisited or saturated
+
+	// Grid Storage
+	const uint16_t CELLS = FieldMap::SIZE * FieldMap::SIZE;
+	uint8_t cost[CELLS];				// Cost to goal
+	uint8_t parents[CELLS / 4];			// 2-bit direction to goal
+	uint8_t openBits[(CELLS + 7) / 8];
+	uint8_t closedBits[(CELLS + 7) / 8];
+
+	// Neighbour offsets (+x, -x, +y, -y)
+	const int8_t DI[4] = { 1, -1, 0, 0 };
+	const int8_t DJ[4] = { 0, 0, 1, -1 };
+
+	// Search State
+	status_t status = PLAN_FAILED;
+	Vec2 goalPos;				// (m)
+	uint8_t startI, startJ;		// Robot cell
+	Vec2 lastWaypoint;			// (m)
+	bool hasWaypoint = false;
+
+	// Private Function Templates
+	bool getBit(const uint8_t*, uint16_t);
+	void setBit(uint8_t*, uint16_t, bool);
+	uint8_t getParent(uint16_t);
+	void setParent(uint16_t, uint8_t);
+	uint8_t cellCost(uint8_t, uint8_t);
+	bool popBest(uint16_t&);
+	bool nearestClosed(uint8_t&, uint8_t&);
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Starts planning a path from the robot to a goal.
+//!i Goal position (x,y) (m)
+//!d Call loop() until it returns PLAN_FOUND or PLAN_FAILED.
+void PathPlanner::start(const Vec2& goal) {
+	for(uint16_t k = 0; k < CELLS; k++) cost[k] = COST_MAX;
+	for(uint16_t k = 0; k < sizeof(openBits); k++) {
+		openBits[k] = 0;
+		closedBits[k] = 0;
+	}
+	goalPos = goal;
+	hasWaypoint = false;
+	uint8_t gi, gj;
+	if(!FieldMap::cellOf(goal, gi, gj) ||
+		!FieldMap::cellOf(Odometer::position, startI, startJ))
+	{
+		status = PLAN_FAILED;
+		return;
+	}
+	uint16_t k = (uint16_t)gj * FieldMap::SIZE + gi;
+	cost[k] = 0;
+	setBit(openBits, k, true);
+	status = PLAN_BUSY;
+}
+
+//!b Runs a few A* expansions.
+//!d Returns search status (see status_t).
+PathPlanner::status_t PathPlanner::loop() {
+	for(uint8_t n = 0; n < STEPS_PER_LOOP &&
+		status == PLAN_BUSY; n++)
+	{
+		uint16_t k;
+		if(!popBest(k)) {
+			status = PLAN_FAILED;
+			break;
+		}
+		setBit(closedBits, k, true);
+		uint8_t i = k % FieldMap::SIZE;
+		uint8_t j = k / FieldMap::SIZE;
+		if(i == startI && j == startJ) {
+			status = PLAN_FOUND;
+			break;
+		}
+
+		// Relax neighbours, each pointing back to this cell. The
+		// robot's own cell is passable even if mapped occupied.
+		for(uint8_t d = 0; d < 4; d++) {
+			uint8_t ni = i + DI[d];
+			uint8_t nj = j + DJ[d];
+			if(ni >= FieldMap::SIZE || nj >= FieldMap::SIZE) continue;
+			uint16_t nk = (uint16_t)nj * FieldMap::SIZE + ni;
+			if(getBit(closedBits, nk)) continue;
+			uint8_t c = (ni == startI && nj == startJ) ?
+				COST_KNOWN : cellCost(ni, nj);
+			if(c == 0 || cost[k] >= COST_MAX - c) continue;
+			if(cost[k] + c < cost[nk]) {
+				cost[nk] = cost[k] + c;
+				setParent(nk, d ^ 1);
+				setBit(openBits, nk, true);
+			}
+		}
+	}
+	return status;
+}
+
+//!b Finds the next waypoint on the path from the robot.
+//!i Waypoint (x,y) (m) (output)
+//!d Follows parents from the robot's cell and returns the
+//!d furthest cell within LOOKAHEAD that is in a straight line of
+//!d sight, or the goal itself once it is in sight. The first step
+//!d is always taken, as it is adjacent to the robot. Line of sight
+//!d shortcuts can leave the robot in a cell the search never
+//!d expanded, in which case parents are followed from the nearest
+//!d expanded neighbour, or else the last waypoint is kept. Returns
+//!d false if the robot is off the plan with no last waypoint.
+bool PathPlanner::waypoint(Vec2& wp) {
+	uint8_t i, j;
+	if(status != PLAN_FOUND ||
+		!FieldMap::cellOf(Odometer::position, i, j))
+	{
+		return false;
+	}
+	if(!nearestClosed(i, j)) {
+		if(!hasWaypoint) return false;
+		wp = lastWaypoint;
+		return true;
+	}
+	uint16_t k = (uint16_t)j * FieldMap::SIZE + i;
+	wp = (cost[k] == 0) ? goalPos : FieldMap::center(i, j);
+	for(uint8_t n = 0; n < LOOKAHEAD && cost[k] != 0; n++) {
+		uint8_t d = getParent(k);
+		i += DI[d];
+		j += DJ[d];
+		k = (uint16_t)j * FieldMap::SIZE + i;
+		Vec2 c = FieldMap::center(i, j);
+		if(n > 0 && !FieldMap::clearPath(Odometer::position, c)) break;
+		wp = (cost[k] == 0) ? goalPos : c;
+	}
+	lastWaypoint = wp;
+	hasWaypoint = true;
+	return true;
+}
+
+//!b Returns cost of entering a cell (0 if impassable).
+uint8_t PathPlanner::cellCost(uint8_t i, uint8_t j) {
+	if(FieldMap::occupied(i, j)) return 0;
+	uint8_t c = (FieldMap::vacant(i, j) || FieldMap::swept(i, j)) ?
+		COST_KNOWN : COST_UNKNOWN;
+	for(uint8_t d = 0; d < 4; d++) {
+		uint8_t ni = i + DI[d];
+		uint8_t nj = j + DJ[d];
+		if(ni < FieldMap::SIZE && nj < FieldMap::SIZE &&
+			FieldMap::occupied(ni, nj))
+		{
+			return c + COST_NEAR_WALL;
+		}
+	}
+	return c;
+}
+
+//!b Removes the open cell with the lowest cost plus heuristic.
+//!i Cell index (output)
+//!d The heuristic is Manhattan distance to the robot's cell.
+//!d Returns false if no cells are open.
+bool PathPlanner::popBest(uint16_t& best) {
+	uint16_t bestF = 0xFFFF;
+	for(uint16_t b = 0; b < sizeof(openBits); b++) {
+		if(openBits[b] == 0) continue;
+		for(uint8_t bit = 0; bit < 8; bit++) {
+			if(!(openBits[b] & (1 << bit))) continue;
+			uint16_t k = b * 8 + bit;
+			uint8_t i = k % FieldMap::SIZE;
+			uint8_t j = k / FieldMap::SIZE;
+			uint16_t f = cost[k] +
+				abs((int)i - startI) + abs((int)j - startJ);
+			if(f < bestF) {
+				bestF = f;
+				best = k;
+			}
+		}
+	}
+	if(bestF == 0xFFFF) return false;
+	setBit(openBits, best, false);
+	return true;
+}
+
+//!b Moves a cell to the nearest expanded cell of the search.
+//!i Cell x index (input and output)
+//!i Cell y index (input and output)
+//!d Keeps the cell if it was expanded, else picks the expanded
+//!d neighbour (diagonals included) with the lowest cost to goal.
+//!d Returns false if there is none.
+bool PathPlanner::nearestClosed(uint8_t& i, uint8_t& j) {
+	uint16_t k = (uint16_t)j * FieldMap::SIZE + i;
+	if(getBit(closedBits, k)) return true;
+	uint8_t bestCost = COST_MAX;
+	uint8_t bi = i, bj = j;
+	for(int8_t dj = -1; dj <= 1; dj++) {
+		for(int8_t di = -1; di <= 1; di++) {
+			uint8_t ni = i + di;
+			uint8_t nj = j + dj;
+			if(ni >= FieldMap::SIZE || nj >= FieldMap::SIZE) continue;
+			uint16_t nk = (uint16_t)nj * FieldMap::SIZE + ni;
+			if(getBit(closedBits, nk) && cost[nk] < bestCost) {
+				bestCost = cost[nk];
+				bi = ni;
+				bj = nj;
+			}
+		}
+	}
+	if(bestCost == COST_MAX) return false;
+	i = bi;
+	j = bj;
+	return true;
+}
+
+//!b Returns a cell's bit from a bitset.
+bool PathPlanner::getBit(const uint8_t* bits, uint16_t k) {
+	return (bits[k >> 3] >> (k & 7)) & 1;
+}
+
+//!b Sets or clears a cell's bit in a bitset.
+void PathPlanner::setBit(uint8_t* bits, uint16_t k, bool v) {
+	if(v) bits[k >> 3] |= (1 << (k & 7));
+	else bits[k >> 3] &= ~(1 << (k & 7));
+}
+
+//!b Returns a cell's parent direction (index into DI, DJ).
+uint8_t PathPlanner::getParent(uint16_t k) {
+	return (parents[k >> 2] >> ((k & 3) * 2)) & 3;
+}
+
+//!b Sets a cell's parent direction (index into DI, DJ).
+void PathPlanner::setParent(uint16_t k, uint8_t d) {
+	uint8_t shift = (k & 3) * 2;
+	parents[k >> 2] = (parents[k >> 2] & ~(3 << shift)) | (d << shift);
+}
@@ -0,0 +1,38 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t PathPlanner.h
+//!b Namespace for final project grid path planner.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Plans a path over the FieldMap grid with A*, searching from
+//!d the goal towards the robot so that every expanded cell ends
+//!d up with a parent pointing one step closer to the goal. The
+//!d robot can then follow parents from whichever cell it is in,
+//!d and no path list is stored. Occupied cells are impassable,
+//!d unknown cells and cells next to occupied ones cost more.
+//!d
+//!d The search runs a few expansions per loop so it never stalls
+//!d the main loop. Per-cell storage is a saturating 8-bit cost,
+//!d a 2-bit parent direction, and open and closed bits.
+
+#pragma once
+#include "Arduino.h"
+#include "Linear.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace PathPlanner {
+	enum status_t {
+		PLAN_BUSY,
+		PLAN_FOUND,
+		PLAN_FAILED,
+	};
+
+	void start(const Vec2&);
+	status_t loop();
+	bool waypoint(Vec2&);
+}
@@ -0,0 +1,139 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Relocalizer.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Relocalizer.h"
+#include "Odometer.h"
+#include "Sonar.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Relocalizer {
+
+	// Relocalization Parameters
+	const float RADIUS = 0.75;			// From home (m)
+	const float AXIS_TOLERANCE = 0.1;	// Heading from axis (rad)
+	const float SONAR_MAX = 1.5;		// Max trusted reading (m)
+	const float AGREE_TOLERANCE = 0.1;	// Between sensors (m)
+	const float MAX_CORRECTION = 0.25;	// Per axis (m)
+	const float GAIN = 0.3;				// Fraction corrected per cycle
+	const uint16_t LOCK_CYCLES = 10;	// Sonar cycles
+
+	// Start Signature (+y, +x, -y, -x) (mm) (0 if invalid)
+	uint16_t signature[4] = { 0, 0, 0, 0 };
+
+	// Correction State
+	uint16_t lastCycle = 0;
+	bool fixedX = false;
+	bool fixedY = false;
+	uint16_t fixCycleX = 0;
+	uint16_t fixCycleY = 0;
+
+	// Private Function Templates
+	uint16_t toMm(float);
+	bool estimate(float, float, float&);
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Stores the sonar signature at the start pose.
+//!d Call this method when the mission starts, with the robot at
+//!d home facing +y and the sonar readings fresh.
+void Relocalizer::capture() {
+	signature[0] = toMm(Sonar::distF);
+	signature[1] = toMm(Sonar::distR);
+	signature[2] = toMm(Sonar::distB);
+	signature[3] = toMm(Sonar::distL);
+	fixedX = false;
+	fixedY = false;
+	lastCycle = Sonar::cycles;
+}
+
+//!b Corrects odometry against the start signature.
+//!d Call this method every loop on the way home. Does nothing
+//!d away from home or unless the robot faces along an axis.
+void Relocalizer::loop() {
+	if(Sonar::cycles == lastCycle) return;
+	lastCycle = Sonar::cycles;
+	if(norm(Odometer::position) > RADIUS) return;
+
+	// Nearest field axis (0 +y, 1 +x, 2 -y, 3 -x)
+	float h = fmod(Odometer::heading, TWO_PI);
+	if(h < 0) h += TWO_PI;
+	uint8_t q = (uint8_t)(h / HALF_PI + 0.5) % 4;
+	if(fabs(h - q * HALF_PI) > AXIS_TOLERANCE &&
+		fabs(h - TWO_PI) > AXIS_TOLERANCE)
+	{
+		return;
+	}
+
+	// Position estimates per axis (sensors clockwise from front)
+	const float dist[4] = {
+		Sonar::distF, Sonar::distR, Sonar::distB, Sonar::distL };
+	float sum[2] = { 0, 0 };	// (y, x) (m)
+	float first[2];
+	uint8_t count[2] = { 0, 0 };
+	bool agree[2] = { true, true };
+	for(uint8_t s = 0; s < 4; s++) {
+		uint8_t w = (q + s) % 4;
+		float e;
+		if(!estimate(signature[w] / 1000.0, dist[s], e)) continue;
+		if(w >= 2) e = -e;		// Facing -y or -x
+		uint8_t a = w % 2;
+		if(count[a] == 0) first[a] = e;
+		else if(fabs(e - first[a]) > AGREE_TOLERANCE) agree[a] = false;
+		sum[a] += e;
+		count[a]++;
+	}
+
+	// Pull odometry towards agreeing estimates
+	Vec2 delta;
+	if(count[1] && agree[1]) {
+		float dx = sum[1] / count[1] - Odometer::position.x;
+		if(fabs(dx) <= MAX_CORRECTION) {
+			delta.x = GAIN * dx;
+			fixedX = true;
+			fixCycleX = Sonar::cycles;
+		}
+	}
+	if(count[0] && agree[0]) {
+		float dy = sum[0] / count[0] - Odometer::position.y;
+		if(fabs(dy) <= MAX_CORRECTION) {
+			delta.y = GAIN * dy;
+			fixedY = true;
+			fixCycleY = Sonar::cycles;
+		}
+	}
+	Odometer::correctPosition(delta);
+}
+
+//!b Returns true if both axes were corrected recently.
+bool Relocalizer::locked() {
+	return fixedX && fixedY &&
+		(uint16_t)(Sonar::cycles - fixCycleX) <= LOCK_CYCLES &&
+		(uint16_t)(Sonar::cycles - fixCycleY) <= LOCK_CYCLES;
+}
+
+//!b Converts a sonar distance to mm (0 if invalid or too far).
+uint16_t Relocalizer::toMm(float d) {
+	if(d <= 0 || d > SONAR_MAX) return 0;
+	return (uint16_t)(d * 1000.0 + 0.5);
+}
+
+//!b Estimates position along a sensor's field direction.
+//!i Signature distance (m)
+//!i Current distance (m)
+//!i Position component (m) (output)
+//!d Returns false if either distance is invalid.
+bool Relocalizer::estimate(float sig, float d, float& e) {
+	if(sig <= 0 || d <= 0 || d > SONAR_MAX) return false;
+	e = sig - d;
+	return true;
+}
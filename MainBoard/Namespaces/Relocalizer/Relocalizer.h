@@ -0,0 +1,31 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Relocalizer.h
+//!b Namespace for final project home pose relocalization.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d At the start pose, the four sonar distances are stored as a
+//!d signature of the walls around home (in mm, indexed by field
+//!d direction +y, +x, -y, -x). Near home, with the robot facing
+//!d along a field axis, each sonar reading facing the same field
+//!d direction as a stored one gives that position component
+//!d directly. Agreeing estimates pull odometry towards them. The
+//!d relocalizer is locked while both axes have been corrected
+//!d recently, and a tighter home threshold can then be used.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Relocalizer {
+	extern uint16_t signature[4];
+
+	void capture();
+	void loop();
+	bool locked();
+}
@@ -10,7 +10,7 @@
 //!d robot relevant to internal computations.
 
 #pragma once
-#include "LinearAtmel.h"
+#include "Arduino.h"
 
 //**************************************************************/
 // NAMESPACE DECLARATION
@@ -10,6 +10,9 @@
 #include "HcSr04Array.h"
 #include "HcSr04.h"
 #include "PinChangeInt.h"
+#include "LoopTimer.h"
+#include "Capture.h"
+#include "Trace.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -33,18 +36,23 @@ namespace Sonar {
 	float distL = 0;
 	float distR = 0;
 
+	// Front Sonar Update Period
+	float periodF = 0.1;	// (s)
+	uint16_t cycles = 0;	// Front sonar updates
+	LoopTimer periodTimer;
+
 	// Sonar Array Object
-	HcSr04Array sensors(4,
-		new uint8_t[4]{
-			PIN_TRIG_F,
-			PIN_TRIG_B,
-			PIN_TRIG_L,
-			PIN_TRIG_R},
-		new uint8_t[4]{
-			PIN_ECHO_F,
-			PIN_ECHO_B,
-			PIN_ECHO_L,
-			PIN_ECHO_R});
+	uint8_t trigPins[4] = {
+		PIN_TRIG_F,
+		PIN_TRIG_B,
+		PIN_TRIG_L,
+		PIN_TRIG_R};
+	uint8_t echoPins[4] = {
+		PIN_ECHO_F,
+		PIN_ECHO_B,
+		PIN_ECHO_L,
+		PIN_ECHO_R};
+	HcSr04Array sensors(4, trigPins, echoPins);
 	bool sonarBegun = false;
 
 	// Front Sonar Interface
@@ -74,56 +82,65 @@ void Sonar::setup() {
 //!d Call this method in the main loop function.
 void Sonar::loop() {
 	if(sonarBegun) {
-		switch(sensors.loop()) {
+		switch(Capture::sonarReady(sensors.loop())) {
 
 			// No sensors updated
 			case 0: break;
 
 			// Front sensor updated
 			case 1:
-				distF = sensors.get(1);
+				periodF = periodTimer.toc();
+				periodTimer.tic();
+				if(cycles < 0xFFFF) cycles++;
+				distF = Capture::sonar(1, sensors.get(1));
 				if(distF != 0) {
 					distF += RobotDims::sonarRadiusF;
 				}
+				TRACE(Trace::EVENT_SONAR, Trace::sonar(1, distF));
 				break;
 
 			// Back sensor updated
 			case 2:
-				distB = sensors.get(2);
+				distB = Capture::sonar(2, sensors.get(2));
 				if(distB != 0) {
 					distB += RobotDims::sonarRadiusB;
 				}
+				TRACE(Trace::EVENT_SONAR, Trace::sonar(2, distB));
 				break;
 
 			// Left sensor updated
 			case 3:
-				distL = sensors.get(3);
+				distL = Capture::sonar(3, sensors.get(3));
 				if(distL != 0) {
 					distL += RobotDims::sonarRadiusL;
 				}
+				TRACE(Trace::EVENT_SONAR, Trace::sonar(3, distL));
 				break;
 
 			// Right sensor updated
 			case 4:
-				distR = sensors.get(4);
+				distR = Capture::sonar(4, sensors.get(4));
 				if(distR != 0) {
 					distR += RobotDims::sonarRadiusR;
 				}
+				TRACE(Trace::EVENT_SONAR, Trace::sonar(4, distR));
 				break;
 
 		}
 	} else {
 		sensors.begin();
+		periodTimer.tic();
 		sonarBegun = true;
 	}
 }
 
 //!b Pings front sonar and returns distance to VTC in meters
 float Sonar::pingFront() {
-	float dist = frontSensor.dist();
+	float dist = Capture::sonar(5, frontSensor.dist());
 	if(dist != 0) {
 		dist += RobotDims::sonarRadiusF;
 	}
+	TRACE(Trace::EVENT_SONAR, Trace::sonar(5, dist));
 	return dist;
 }
 
@@ -12,9 +12,12 @@
 //!d method of this function continuously updates the variables
 //!d distF, distB, distL, and distR (front, back, left, and
 //!d right sonar distances) which reflect the distances from the
-//!d VTC of the robot (not the sensors themselves).
+//!d VTC of the robot (not the sensors themselves). The time
+//!d between front sonar updates is tracked in periodF, and the
+//!d number of front sonar updates in cycles.
 
 #pragma once
+#include "Arduino.h"
 
 //**************************************************************/
 // NAMESPACE DECLARATION
@@ -25,6 +28,8 @@ namespace Sonar {
 	extern float distB;
 	extern float distL;
 	extern float distR;
+	extern float periodF;
+	extern uint16_t cycles;
 
 	void setup();
 	void loop();
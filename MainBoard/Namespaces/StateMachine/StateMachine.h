@@ -0,0 +1,152 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t StateMachine.h
+//!b Template class for table-driven state machines.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d A state machine is defined by a constant table with one
+//!d entry per state number. Each entry holds an optional guard
+//!d and a handler, both of which return the next state number or
+//!d STATE_SAME to stay put. The guard runs first each loop, so
+//!d transitions shared by several states (e.g. cliff detection)
+//!d are written once. The machine records when the current state
+//!d was entered and the last transition time, and keeps the
+//!d cumulative dwell time and entry count of every state in
+//!d fixed arrays (no heap). Transitions are logged to the event
+//!d trace under the event given at construction.
+
+#pragma once
+#include "Arduino.h"
+#include "Trace.h"
+#include "Capture.h"
+
+//**************************************************************/
+// CONSTANTS
+//**************************************************************/
+
+// Returned by guards and handlers to stay in the current state
+const uint8_t STATE_SAME = 0xFF;
+
+//**************************************************************/
+// CLASS DECLARATION
+//**************************************************************/
+
+template<uint8_t N>
+class StateMachine {
+public:
+	typedef uint8_t (*handler_t)();
+	struct Entry {
+		handler_t guard;
+		handler_t run;
+	};
+
+	StateMachine(const Entry*, uint8_t, uint8_t);
+
+	void loop();
+	void set(uint8_t);
+	uint8_t get() const;
+
+	unsigned long enteredAt() const;
+	unsigned long exitedAt() const;
+	float dwellTime(uint8_t) const;
+	uint16_t entries(uint8_t) const;
+	void clearTiming();
+
+private:
+	const Entry* table;
+	uint8_t traceEvent;
+	uint8_t state;
+	unsigned long entryMs;
+	unsigned long exitMs;
+	unsigned long dwellMs[N];
+	uint16_t entryCount[N];
+};
+
+//**************************************************************/
+// CLASS FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Constructs state machine.
+//!i Transition table indexed by state number (N entries)
+//!i Initial state
+//!i Trace event for transitions (see Trace::event_t)
+template<uint8_t N>
+StateMachine<N>::StateMachine(
+	const Entry* table, uint8_t initial, uint8_t traceEvent)
+{
+	this->table = table;
+	this->traceEvent = traceEvent;
+	state = initial;
+	clearTiming();
+}
+
+//!b Runs guard and handler of the current state.
+//!d Transitions if either returns a state other than STATE_SAME.
+template<uint8_t N>
+void StateMachine<N>::loop() {
+	const Entry& e = table[state];
+	uint8_t next = STATE_SAME;
+	if(e.guard) next = e.guard();
+	if(next == STATE_SAME && e.run) next = e.run();
+	if(next != STATE_SAME) set(next);
+}
+
+//!b Transitions to given state and updates state timing.
+template<uint8_t N>
+void StateMachine<N>::set(uint8_t next) {
+	unsigned long now = Capture::millis();
+	TRACE(traceEvent, ((uint16_t)state << 8) | next);
+	dwellMs[state] += now - entryMs;
+	exitMs = now;
+	entryMs = now;
+	state = next;
+	entryCount[state]++;
+}
+
+//!b Returns current state number.
+template<uint8_t N>
+uint8_t StateMachine<N>::get() const {
+	return state;
+}
+
+//!b Returns time (ms) the current state was entered.
+template<uint8_t N>
+unsigned long StateMachine<N>::enteredAt() const {
+	return entryMs;
+}
+
+//!b Returns time (ms) of the last state exit.
+template<uint8_t N>
+unsigned long StateMachine<N>::exitedAt() const {
+	return exitMs;
+}
+
+//!b Returns cumulative time (s) spent in given state.
+//!d Includes time so far if it is the current state.
+template<uint8_t N>
+float StateMachine<N>::dwellTime(uint8_t s) const {
+	unsigned long ms = dwellMs[s];
+	if(s == state) ms += Capture::millis() - entryMs;
+	return ms * 0.001;
+}
+
+//!b Returns number of times given state was entered.
+template<uint8_t N>
+uint16_t StateMachine<N>::entries(uint8_t s) const {
+	return entryCount[s];
+}
+
+//!b Clears all state timing.
+//!d The current state counts as entered now.
+template<uint8_t N>
+void StateMachine<N>::clearTiming() {
+	for(uint8_t i = 0; i < N; i++) {
+		dwellMs[i] = 0;
+		entryCount[i] = 0;
+	}
+	entryMs = Capture::millis();
+	exitMs = entryMs;
+	entryCount[state] = 1;
+}
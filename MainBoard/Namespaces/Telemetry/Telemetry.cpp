@@ -0,0 +1,49 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Telemetry.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Telemetry.h"
+#include "FireBot.h"
+#include "WallFollower.h"
+#include "Odometer.h"
+#include "Sonar.h"
+#include "Battery.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Telemetry {
+	Frame frame;
+	uint32_t cycle = 0;
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Publishes a frame of this control cycle's data.
+//!d Call this method once per loop after all updates.
+void Telemetry::publish() {
+	Frame& f = frame;
+	f.cycle = ++cycle;
+	f.fireBotState = FireBot::getState();
+	f.wallState = WallFollower::getState();
+	f.position = Odometer::position;
+	f.heading = Odometer::heading;
+	f.distF = Sonar::distF;
+	f.distB = Sonar::distB;
+	f.distL = Sonar::distL;
+	f.distR = Sonar::distR;
+	f.flamePos = FireBot::flamePos;
+	f.battery = Battery::voltage;
+}
+
+//!b Copies the latest published frame.
+//!i Frame to copy into
+void Telemetry::read(Frame& f) {
+	f = frame;
+}
@@ -0,0 +1,43 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Telemetry.h
+//!b Namespace for final project telemetry snapshots.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Once per control cycle, publish() copies the robot data that
+//!d Matlab reports into one frame, tagged with the cycle number,
+//!d so every reader sees values from the same cycle, even while
+//!d the live globals change later in the loop. Frames are
+//!d published from boot onwards, and also while in fault mode.
+//!d
+//!d publish() and read() must both run in the main loop, as all
+//!d current readers do. The frame is not safe to read from an ISR.
+
+#pragma once
+#include "Arduino.h"
+#include "Linear.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Telemetry {
+	struct Frame {
+		uint32_t cycle;			// Control cycle number
+		uint8_t fireBotState;
+		uint8_t wallState;
+		Vec2 position;			// (m)
+		float heading;			// (rad)
+		float distF;			// Sonar distances (m)
+		float distB;
+		float distL;
+		float distR;
+		Vec3 flamePos;			// (m)
+		float battery;			// (V)
+	};
+
+	void publish();
+	void read(Frame&);
+}
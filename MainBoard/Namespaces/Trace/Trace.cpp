@@ -0,0 +1,101 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Trace.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "Trace.h"
+#if TRACE_ENABLED
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace Trace {
+
+	// Main Loop Buffer
+	Record buffer[SIZE];
+	uint8_t head = 0;	// Next record to write
+	uint8_t count = 0;	// Records in buffer
+
+	// ISR Buffer
+	Record isrBuffer[ISR_SIZE];
+	volatile uint8_t isrHead = 0;		// Next record to write (ISRs)
+	volatile uint8_t isrTail = 0;		// Next record to read (loop)
+	volatile uint8_t isrDropped = 0;	// Records lost since boot
+
+	// Writer Cost (CPU cycles per event)
+	const uint8_t MEASURE_EVENTS = 32;
+	uint16_t loopCost = 0;
+	uint16_t isrCost = 0;
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Times both writers and empties the buffers.
+//!d Call this method once in the main setup function. Each
+//!d writer logs MEASURE_EVENTS records back to back, timed with
+//!d the 4 us micros clock. The ISR writer is timed with
+//!d interrupts off, as it would run in an ISR.
+void Trace::measure() {
+	uint32_t start = ::micros();
+	for(uint8_t i = 0; i < MEASURE_EVENTS; i++) log(0, i);
+	uint32_t end = ::micros();
+	loopCost = (end - start) * (F_CPU / 1000000) / MEASURE_EVENTS;
+	uint8_t sreg = SREG;
+	cli();
+	start = ::micros();
+	for(uint8_t i = 0; i < MEASURE_EVENTS; i++) logIsr(0, i);
+	end = ::micros();
+	SREG = sreg;
+	isrCost = (end - start) * (F_CPU / 1000000) / MEASURE_EVENTS;
+	clear();
+}
+
+//!b Returns number of records in both buffers.
+uint8_t Trace::size() {
+	return count + ((isrHead - isrTail) & (ISR_SIZE - 1));
+}
+
+//!b Removes the oldest record from a buffer.
+//!i Record to copy it into
+//!d Empties the main loop buffer first, then the ISR buffer.
+//!d Returns false if both are empty.
+bool Trace::pop(Record& r) {
+	if(count > 0) {
+		r = buffer[(head - count) & (SIZE - 1)];
+		count--;
+		return true;
+	}
+	uint8_t tail = isrTail;
+	if(tail == isrHead) return false;
+	r = isrBuffer[tail];
+	isrTail = (tail + 1) & (ISR_SIZE - 1);
+	return true;
+}
+
+//!b Discards all records.
+void Trace::clear() {
+	count = 0;
+	isrTail = isrHead;
+}
+
+//!b Returns measured cost of a main loop event (CPU cycles).
+uint16_t Trace::loopCycles() {
+	return loopCost;
+}
+
+//!b Returns measured cost of an ISR event (CPU cycles).
+uint16_t Trace::isrCycles() {
+	return isrCost;
+}
+
+//!b Returns ISR records dropped since boot (saturates at 255).
+uint8_t Trace::dropped() {
+	return isrDropped;
+}
+
+#endif
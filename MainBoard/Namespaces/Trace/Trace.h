@@ -0,0 +1,155 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t Trace.h
+//!b Namespace for final project event trace buffer.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d Events are logged with the TRACE macro into a fixed ring
+//!d buffer of compact records (time, event, payload), which
+//!d Matlab can dump to show a timeline of a run. When the
+//!d buffer is full the oldest record is overwritten.
+//!d
+//!d Each buffer has a single producer, so no writer waits or
+//!d holds interrupts off. TRACE may only be used in the main loop,
+//!d which also drains the buffers. Encoder ISR events are very
+//!d frequent, so they use the TRACE_ISR macro, which also needs
+//!d TRACE_ISR_ENABLED. It writes a separate buffer that only ISRs
+//!d fill (AVR ISRs do not nest), and which the main loop empties
+//!d from the other end, so there is one writer per index. A full
+//!d ISR buffer drops new records and counts them. With
+//!d TRACE_ENABLED set to 0 both macros and the buffers compile out
+//!d entirely.
+//!d
+//!d Records are stamped with the raw micros clock, not the loop
+//!d time, so ISR bursts within one loop can be told apart. Reading
+//!d the clock is most of the cost of an event, which measure()
+//!d times on the robot.
+//!d
+//!d Event payloads:
+//!d - FIREBOT_STATE:      old state << 8 | new state
+//!d - WALLFOLLOWER_STATE: old state << 8 | new state
+//!d - SONAR:              sensor (1-4 array, 5 ping) << 12 |
+//!d                       distance (mm, max 4095)
+//!d - ENCODER_L/R:        encoder channel (0 A, 1 B)
+//!d - PID_SATURATED:      controller (pid_t), 0x100 set if high
+//!d - MATLAB:             message type byte
+//!d - HEADING_FIX:        heading correction (mrad) (int16)
+
+#pragma once
+#include "Arduino.h"
+
+// Set to 1 to log events to the trace buffer
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+// Set to 1 to also log encoder ISR events
+#ifndef TRACE_ISR_ENABLED
+#define TRACE_ISR_ENABLED 0
+#endif
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace Trace {
+	enum event_t {
+		EVENT_FIREBOT_STATE = 0x01,
+		EVENT_WALLFOLLOWER_STATE = 0x02,
+		EVENT_SONAR = 0x03,
+		EVENT_ENCODER_L = 0x04,
+		EVENT_ENCODER_R = 0x05,
+		EVENT_PID_SATURATED = 0x06,
+		EVENT_MATLAB = 0x07,
+		EVENT_HEADING_FIX = 0x08,
+	};
+	enum pid_t {
+		PID_WHEEL_L = 1,
+		PID_WHEEL_R = 2,
+		PID_HEADING = 3,
+		PID_LEFT_WALL = 4,
+		PID_FRONT_WALL = 5,
+	};
+
+	struct Record {
+		uint32_t time;		// (us)
+		uint8_t event;
+		uint16_t payload;
+	} __attribute__((packed));
+
+	// Buffer size (records) (power of 2)
+	const uint8_t SIZE = 64;
+
+	//!b Packs a sonar reading into an event payload.
+	//!i Sensor number
+	//!i Distance (m)
+	inline uint16_t sonar(uint8_t sensor, float dist) {
+		uint16_t mm = (dist < 4.095) ? (uint16_t)(dist * 1000.0) : 4095;
+		return ((uint16_t)sensor << 12) | mm;
+	}
+
+#if TRACE_ENABLED
+	// Buffer size for ISR events (records) (power of 2)
+	const uint8_t ISR_SIZE = 32;
+
+	extern Record buffer[SIZE];
+	extern uint8_t head;
+	extern uint8_t count;
+	extern Record isrBuffer[ISR_SIZE];
+	extern volatile uint8_t isrHead;
+	extern volatile uint8_t isrTail;
+	extern volatile uint8_t isrDropped;
+
+	void measure();
+	uint8_t size();
+	bool pop(Record&);
+	void clear();
+	uint16_t loopCycles();
+	uint16_t isrCycles();
+	uint8_t dropped();
+
+	//!b Logs an event to the trace buffer.
+	//!i Event (see event_t)
+	//!i Payload
+	//!d Only call this method from the main loop.
+	inline void log(uint8_t event, uint16_t payload) {
+		Record& r = buffer[head];
+		r.time = ::micros();
+		r.event = event;
+		r.payload = payload;
+		head = (head + 1) & (SIZE - 1);
+		if(count < SIZE) count++;
+	}
+
+	//!b Logs an event to the ISR trace buffer.
+	//!i Event (see event_t)
+	//!i Payload
+	//!d Only call this method from ISRs.
+	inline void logIsr(uint8_t event, uint16_t payload) {
+		uint8_t next = (isrHead + 1) & (ISR_SIZE - 1);
+		if(next == isrTail) {
+			if(isrDropped < 0xFF) isrDropped++;
+			return;
+		}
+		Record& r = isrBuffer[isrHead];
+		r.time = ::micros();
+		r.event = event;
+		r.payload = payload;
+		isrHead = next;
+	}
+#endif
+}
+
+#if TRACE_ENABLED
+#define TRACE(event, payload) Trace::log((event), (payload))
+#else
+#define TRACE(event, payload) ((void)0)
+#endif
+
+#if TRACE_ENABLED && TRACE_ISR_ENABLED
+#define TRACE_ISR(event, payload) Trace::logIsr((event), (payload))
+#else
+#define TRACE_ISR(event, payload) ((void)0)
+#endif
@@ -0,0 +1,76 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t VelocityPlanner.cpp
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+#include "VelocityPlanner.h"
+#include "Sonar.h"
+#include "LoopTimer.h"
+
+//**************************************************************/
+// NAMESPACE FIELD DEFINITIONS
+//**************************************************************/
+
+namespace VelocityPlanner {
+
+	// Planner Parameters
+	const float ACCEL_MAX = 0.4;	// Speed-up rate (m/s^2)
+	const float DECEL_MAX = 0.3;	// Planned braking rate (m/s^2)
+
+	// Planned Velocity
+	float velocity = 0;	// (m/s)
+	LoopTimer timer;
+}
+
+//**************************************************************/
+// NAMESPACE FUNCTION DEFINITIONS
+//**************************************************************/
+
+//!b Resets planned velocity to given velocity (m/s).
+//!d Call this method when wall-following (re)starts.
+void VelocityPlanner::reset(float v) {
+	velocity = v;
+	timer.tic();
+}
+
+//!b Plans drive velocity (m/s) for one control cycle.
+//!i Cruise velocity (m/s)
+//!i Turn velocity (m/s)
+//!i Front clearance to turn point (m) (negative if unknown)
+//!i True if a turn is coming up on the left side
+//!i Cliff sensor margin (0 at cliff, 1 if clear)
+//!d The result is the lowest of the braking-distance limit for
+//!d the front clearance, the turn-ahead limit, and the cliff
+//!d limit. Speeding up is rate-limited, slowing down is not.
+float VelocityPlanner::plan(float vMax, float vTurn,
+	float frontClear, bool turnAhead, float cliffMargin)
+{
+	float vPlan = vMax;
+
+	// Braking distance to front turn point
+	if(frontClear >= 0) {
+		float d = frontClear - velocity * Sonar::periodF;
+		if(d < 0) d = 0;
+		float vFront = sqrt(vTurn * vTurn + 2.0 * DECEL_MAX * d);
+		if(vFront < vPlan) vPlan = vFront;
+	}
+
+	// Upcoming left turn
+	if(turnAhead && vTurn < vPlan) {
+		vPlan = vTurn;
+	}
+
+	// Cliff sensor margin
+	cliffMargin = constrain(cliffMargin, 0.0, 1.0);
+	float vCliff = vTurn + (vMax - vTurn) * cliffMargin;
+	if(vCliff < vPlan) vPlan = vCliff;
+
+	// Rate-limit speeding up
+	float dt = timer.toc();
+	timer.tic();
+	float vRise = velocity + ACCEL_MAX * dt;
+	velocity = (vPlan < vRise) ? vPlan : vRise;
+	return velocity;
+}
@@ -0,0 +1,28 @@
+//**************************************************************/
+// TITLE
+//**************************************************************/
+
+//!t VelocityPlanner.h
+//!b Namespace for final project look-ahead velocity planner.
+//!a Dan Oates (RBE-2002 B17 Team 10)
+
+//!d This namespace sets the wall-following drive velocity from
+//!d the clearance ahead of the robot. The robot runs at cruise
+//!d speed on clear segments and brakes down to turn speed ahead
+//!d of front walls, outside corners, and cliffs. Front clearance
+//!d is discounted by the distance covered between front sonar
+//!d updates.
+
+#pragma once
+#include "Arduino.h"
+
+//**************************************************************/
+// NAMESPACE DECLARATION
+//**************************************************************/
+
+namespace VelocityPlanner {
+	extern float velocity;
+
+	void reset(float);
+	float plan(float, float, float, bool, float);
+}
@@ -9,7 +9,11 @@
 #include "Sonar.h"
 #include "Odometer.h"
 #include "DriveSystem.h"
-#include "PidController.h"
+#include "FixedPid.h"
+#include "VelocityPlanner.h"
+#include "Capture.h"
+#include "LoopTimer.h"
+#include "StateMachine.h"
 
 //**************************************************************/
 // NAMESPACE FIELD DEFINITIONS
@@ -25,11 +29,24 @@ namespace WallFollower {
 	const float WALL_DISTANCE 		 = 0.23;	// From VTC (m)
 	const float LEFT_WALL_TOLERANCE  = 0.1;		// (m)
 	const float FRONT_WALL_TOLERANCE = 0.02;	// (m)
-	const float DRIVE_VELOCITY_MAX	 = 0.15;	// (m/s)
+	const float DRIVE_VELOCITY_MAX	 = 0.15;	// Turn speed (m/s)
+	const float DRIVE_VELOCITY_CRUISE = 0.35;	// (m/s)
 	const float PRE_TURN_DISTANCE	 = 0.047;	// (m)
 	const float CLIFF_BACK_DISTANCE  =
 		WALL_DISTANCE - 0.0353;				// (m)
 	const float WALL_CHECK_DIST = 0.062;	// (m)
+	const int CLIFF_THRESHOLD = 500;		// (ADC)
+	const int CLIFF_SLOW_MARGIN = 200;		// (ADC)
+
+	// Arc Turn Parameters
+	const bool ARC_TURNS = true;			// Enable arc turns
+	const float ARC_RADIUS_MIN = 0.12;		// (m)
+	const float ARC_RADIUS_MAX = 0.30;		// (m)
+	const float ARC_VELOCITY = DRIVE_VELOCITY_MAX;	// (m/s)
+
+	// Front distance where planner must reach turn speed (m)
+	const float FRONT_PLAN_DISTANCE =
+		WALL_DISTANCE + ARC_RADIUS_MAX;
 
 	// Derived Parameters
 	const float PRE_TURN_TIME 	=
@@ -49,14 +66,40 @@ namespace WallFollower {
 		STATE_POST_TURN = 6,
 		STATE_BACK_FROM_CLIFF = 7,
 		STATE_TURN_RIGHT = 8,
-	} state, pausedState;
+		STATE_ARC_LEFT = 9,
+		STATE_ARC_RIGHT = 10,
+		NUM_STATES,
+	};
+	uint8_t pausedState;
 	enum direction_t {
 		POS_Y, // +y
 		POS_X, // -y
 		NEG_Y, // +x
 		NEG_X, // -x
 	} direction;
-	Timer timer;
+	LoopTimer timer;
+	int cliff = 0;	// Last cliff reading (ADC)
+
+	// Arc Turn State
+	float lastWallDist = WALL_DISTANCE;	// (m)
+	float arcRadius = 0;		// (m)
+	float arcStart = 0;			// (m)
+	float arcHeading = 0;		// (rad)
+
+	// Wall Heading Fit
+	// Fits left wall distance against travel in FORWARD. The slope
+	// gives the true heading relative to the axis-aligned wall,
+	// which is compared to the mean odometer heading to find drift.
+	const float FIT_LENGTH = 0.40;		// Travel per fit (m)
+	const uint8_t FIT_MIN_SAMPLES = 8;
+	const float FIT_MAX_RMS = 0.01;		// Wall straightness (m)
+	const float FIT_MAX_ERROR = 0.15;	// Outlier rejection (rad)
+	const float FIT_GAIN = 0.5;			// Fraction corrected per fit
+	uint16_t fitCycle = 0;	// Last sonar cycle used
+	uint8_t fitN = 0;		// Samples in fit
+	float fitStart = 0;		// Odometer distance at start (m)
+	float fitS = 0, fitD = 0, fitH = 0;		// Sums
+	float fitSS = 0, fitSD = 0, fitDD = 0;	// Sums of products
 
 	// Left wall-following PID Controller
 	// Input: Left wall distance to VTC (m)
@@ -65,7 +108,7 @@ namespace WallFollower {
 	const float L_KI = 0;
 	const float L_KD = 0;
 	const float MAX_HEADING_CHANGE = 0.2;
-	PidController leftWallPid(L_KP, L_KI, L_KD,
+	FixedPid<12> leftWallPid(L_KP, L_KI, L_KD,
 		-MAX_HEADING_CHANGE,
 		+MAX_HEADING_CHANGE);
 	float headingOffset = 0;
@@ -77,16 +120,55 @@ namespace WallFollower {
 	const float F_KP = 1.5;
 	const float F_KI = 0;
 	const float F_KD = 0;
-	PidController frontWallPid(F_KP, F_KI, F_KD,
-		0, DRIVE_VELOCITY_MAX);
+	FixedPid<12> frontWallPid(F_KP, F_KI, F_KD,
+		0, DRIVE_VELOCITY_CRUISE);
 	float driveVelocity = DRIVE_VELOCITY_MAX;
 
 	// Private Function Templates
+	uint8_t resumeState(uint8_t);
 	bool nearLeftWall();
 	bool nearFrontWall();
-	bool nearCliff();
+	bool nearFrontArc();
+	int cliffReading();
+	bool leftTurnAhead();
 	void setDirectionLeft();
 	void setDirectionRight();
+	uint8_t checkFrontWall();
+	void startArc(float);
+	bool followArc();
+	void updateFit();
+	void applyFit();
+
+	// State Handlers
+	uint8_t cliffGuard();
+	uint8_t stateStopped();
+	uint8_t stateForward();
+	uint8_t stateCheckLeft();
+	uint8_t statePreTurnLeft();
+	uint8_t stateTurnLeft();
+	uint8_t statePostTurn();
+	uint8_t stateBackFromCliff();
+	uint8_t stateTurnRight();
+	uint8_t stateArcLeft();
+	uint8_t stateArcRight();
+
+	// State Machine
+	// Guarded states back away from cliffs before running.
+	constexpr StateMachine<NUM_STATES>::Entry table[NUM_STATES] = {
+		{ nullptr,		nullptr },
+		{ nullptr,		stateStopped },
+		{ cliffGuard,	stateForward },
+		{ cliffGuard,	stateCheckLeft },
+		{ cliffGuard,	statePreTurnLeft },
+		{ nullptr,		stateTurnLeft },
+		{ cliffGuard,	statePostTurn },
+		{ nullptr,		stateBackFromCliff },
+		{ nullptr,		stateTurnRight },
+		{ cliffGuard,	stateArcLeft },
+		{ cliffGuard,	stateArcRight },
+	};
+	StateMachine<NUM_STATES> machine(
+		table, STATE_STOPPED, Trace::EVENT_WALLFOLLOWER_STATE);
 }
 
 //**************************************************************/
@@ -98,6 +180,8 @@ namespace WallFollower {
 void WallFollower::setup() {
 	pinMode(PIN_CLIFFSENSE_L, INPUT);
 	pinMode(PIN_CLIFFSENSE_R, INPUT);
+	leftWallPid.setTraceId(Trace::PID_LEFT_WALL);
+	frontWallPid.setTraceId(Trace::PID_FRONT_WALL);
 	direction = POS_Y;
 	pausedState = STATE_FORWARD;
 	start();
@@ -106,16 +190,60 @@ void WallFollower::setup() {
 //!b Initializes wall-follower to state before it was stopped.
 void WallFollower::start() {
 	driveVelocity = DRIVE_VELOCITY_MAX;
+	VelocityPlanner::reset(DRIVE_VELOCITY_MAX);
 	timer.resume();
-	state = pausedState;
+	machine.set(pausedState);
+}
+
+//!b Starts wall-following forwards along the nearest axis.
+//!d Use this instead of start() after the robot has driven away
+//!d from the wall it was following.
+void WallFollower::restart() {
+	float h = fmod(Odometer::heading, TWO_PI);
+	if(h < 0) h += TWO_PI;
+	direction = (direction_t)((uint8_t)(h / HALF_PI + 0.5) % 4);
+	pausedState = STATE_FORWARD;
+	start();
 }
 
 //!b Stops drive system and sets wall-follower to stopped state.
+//!d Does nothing if already stopped, so the state to return to
+//!d is kept.
 void WallFollower::stop() {
+	if(machine.get() == STATE_STOPPED) return;
 	DriveSystem::stop();
-	pausedState = state;
+	pausedState = machine.get();
 	timer.pause();
-	state = STATE_STOPPED;
+	machine.set(STATE_STOPPED);
+}
+
+//!b Restores wall-follower from a mission checkpoint.
+//!i State
+//!i State before it was stopped
+//!i Direction (see direction_t)
+void WallFollower::resume(uint8_t state, uint8_t paused, uint8_t dir) {
+	direction = (direction_t)dir;
+	if(state == STATE_STOPPED) {
+		pausedState = resumeState(paused);
+		machine.set(STATE_STOPPED);
+	} else {
+		pausedState = resumeState(state);
+		start();
+	}
+}
+
+//!b Returns state to resume in for a checkpointed state.
+//!d Arcs cannot be resumed part way, so they go back to forward
+//!d driving. Other states restart safely from their beginning.
+uint8_t WallFollower::resumeState(uint8_t state) {
+	switch(state) {
+		case STATE_STOPPED:
+		case STATE_ARC_LEFT:
+		case STATE_ARC_RIGHT:
+			return STATE_FORWARD;
+		default:
+			return state;
+	}
 }
 
 //!b Returns true if robot is near left wall.
@@ -142,155 +270,358 @@ bool WallFollower::nearFrontWall() {
 	}
 }
 
+//!b Returns true if front wall is close enough for a right arc.
+//!d Always false if arc turns are disabled.
+bool WallFollower::nearFrontArc() {
+	return ARC_TURNS &&
+		Sonar::distF != 0 &&
+		Sonar::distF <= WALL_DISTANCE + ARC_RADIUS_MAX;
+}
+
 //!b Returns true if robot is near a cliff.
 bool WallFollower::nearCliff() {
-	return
-		analogRead(PIN_CLIFFSENSE_L) >= 500 ||
-		analogRead(PIN_CLIFFSENSE_R) >= 500;
+	cliff = cliffReading();
+	return cliff >= CLIFF_THRESHOLD;
+}
+
+//!b Returns the higher of the two cliff sensor readings (ADC).
+int WallFollower::cliffReading() {
+	int l = Capture::analog(PIN_CLIFFSENSE_L);
+	int r = Capture::analog(PIN_CLIFFSENSE_R);
+	return (l > r) ? l : r;
+}
+
+//!b Returns true if the left wall is falling away.
+//!d Used to slow down ahead of an outside corner.
+bool WallFollower::leftTurnAhead() {
+	return Sonar::distL != 0 &&
+		Sonar::distL > WALL_DISTANCE +
+		0.5 * LEFT_WALL_TOLERANCE;
 }
 
 //!b Performs wall-following loop.
 void WallFollower::loop() {
-	switch(state) {
+	machine.loop();
+}
 
-		// Stopped (no movement)
-		case STATE_STOPPED:
-			break;
-
-		// Driving forwards
-		case STATE_FORWARD:
-			// Wall following
-			if(Sonar::distL != 0) {
-				headingOffset = leftWallPid.update(
-					WALL_DISTANCE - Sonar::distL);
-				driveHeading =
-					targetHeading() + headingOffset;
-			} else {
-				driveHeading = targetHeading();
-			}
-			if(Sonar::distF != 0) {
-				driveVelocity = frontWallPid.update(
-					Sonar::distF - WALL_DISTANCE);
-			}
-			DriveSystem::drive(
-				driveHeading,
-				driveVelocity);
-
-			// State changes
-			if(nearCliff()) {
-				stop();
-				timer.tic();
-				state = STATE_BACK_FROM_CLIFF;
-			}
-			if(!nearLeftWall()) {
-				timer.tic();
-				state = STATE_CHECK_LEFT;
-			}
-			if(nearFrontWall()) {
-				setDirectionRight();
-				state = STATE_TURN_RIGHT;
-			}
-			break;
-
-		// Drive straight then re-check left side
-		case STATE_CHECK_LEFT:
-			DriveSystem::drive(
-				targetHeading(),
-				DRIVE_VELOCITY_MAX);
-			if(nearCliff()) {
-				stop();
-				timer.tic();
-				state = STATE_BACK_FROM_CLIFF;
-			}
-			if(nearLeftWall()) {
-				driveVelocity = DRIVE_VELOCITY_MAX;
-				state = STATE_FORWARD;
-			} else if(timer.hasElapsed(WALL_CHECK_TIME)) {
-				timer.tic();
-				state = STATE_PRE_TURN_LEFT;
-			}
-			break;
-
-		// Drive forwards before left turn
-		case STATE_PRE_TURN_LEFT:
-			DriveSystem::drive(
-				targetHeading(),
-				DRIVE_VELOCITY_MAX);
-			if(nearCliff()) {
-				stop();
-				timer.tic();
-				state = STATE_BACK_FROM_CLIFF;
-			}
-			if(nearFrontWall()) {
-				setDirectionRight();
-				state = STATE_TURN_RIGHT;
-			}
-			if(timer.hasElapsed(PRE_TURN_TIME)) {
-				setDirectionLeft();
-				state = STATE_TURN_LEFT;
-			}
-			break;
-
-		// Make a 90-degree left turn
-		case STATE_TURN_LEFT:
-			if(DriveSystem::drive(targetHeading())) {
-				state = STATE_POST_TURN;
-			}
-			break;
-
-		// Drive forwards after a turn
-		case STATE_POST_TURN:
-			DriveSystem::drive(
-				targetHeading(),
-				DRIVE_VELOCITY_MAX);
-			if(nearCliff()) {
-				stop();
-				timer.tic();
-				state = STATE_BACK_FROM_CLIFF;
-			}
-			if(nearLeftWall()) {
-				driveVelocity = DRIVE_VELOCITY_MAX;
-				state = STATE_FORWARD;
-			}
-			if(nearFrontWall()) {
-				setDirectionRight();
-				state = STATE_TURN_RIGHT;
-			}
-			break;
-
-		// Back away from a cliff
-		case STATE_BACK_FROM_CLIFF:
-			DriveSystem::drive(
-				targetHeading(),
-				-DRIVE_VELOCITY_MAX);
-			if(timer.hasElapsed(CLIFF_BACK_TIME)) {
-				setDirectionRight();
-				state = STATE_TURN_RIGHT;
-			}
-			break;
-
-		// Make a 90-degree right turn
-		case STATE_TURN_RIGHT:
-			if(DriveSystem::drive(targetHeading())) {
-				state = STATE_POST_TURN;
-			}
-			break;
+//!b Backs away from a cliff if one is detected.
+//!d Shared guard of all states that drive forwards.
+uint8_t WallFollower::cliffGuard() {
+	if(nearCliff()) {
+		DriveSystem::stop();
+		timer.tic();
+		return STATE_BACK_FROM_CLIFF;
+	}
+	return STATE_SAME;
+}
+
+//!b Stopped (no movement).
+uint8_t WallFollower::stateStopped() {
+	return STATE_SAME;
+}
+
+//!b Drives forwards along the left wall.
+//!d Uses the cliff reading taken by the cliff guard.
+uint8_t WallFollower::stateForward() {
+
+	// Wall following
+	if(Sonar::distL != 0) {
+		if(nearLeftWall()) {
+			lastWallDist = Sonar::distL;
+			updateFit();
+		}
+		headingOffset = leftWallPid.update(
+			WALL_DISTANCE - Sonar::distL);
+		driveHeading =
+			targetHeading() + headingOffset;
+	} else {
+		driveHeading = targetHeading();
+	}
+	if(Sonar::distF != 0) {
+		driveVelocity = frontWallPid.update(
+			Sonar::distF - WALL_DISTANCE);
+	}
+
+	// Velocity planning
+	float frontClear = -1;
+	if(Sonar::distF != 0) {
+		frontClear = Sonar::distF - FRONT_PLAN_DISTANCE;
+		if(frontClear < 0) frontClear = 0;
+	}
+	float vPlan = VelocityPlanner::plan(
+		DRIVE_VELOCITY_CRUISE,
+		DRIVE_VELOCITY_MAX,
+		frontClear,
+		leftTurnAhead(),
+		(float)(CLIFF_THRESHOLD - cliff) / CLIFF_SLOW_MARGIN);
+	DriveSystem::drive(
+		driveHeading,
+		min(driveVelocity, vPlan));
+
+	// State changes
+	uint8_t next = STATE_SAME;
+	if(!nearLeftWall()) {
+		timer.tic();
+		next = STATE_CHECK_LEFT;
+	}
+	uint8_t front = checkFrontWall();
+	return (front != STATE_SAME) ? front : next;
+}
+
+//!b Drives straight then re-checks left side.
+uint8_t WallFollower::stateCheckLeft() {
+	DriveSystem::drive(
+		targetHeading(),
+		DRIVE_VELOCITY_MAX);
+	if(nearLeftWall()) {
+		driveVelocity = DRIVE_VELOCITY_MAX;
+		VelocityPlanner::reset(DRIVE_VELOCITY_MAX);
+		return STATE_FORWARD;
+	} else if(timer.hasElapsed(WALL_CHECK_TIME)) {
+		if(ARC_TURNS) {
+			startArc(-(lastWallDist - PRE_TURN_DISTANCE));
+			return STATE_ARC_LEFT;
+		} else {
+			timer.tic();
+			return STATE_PRE_TURN_LEFT;
+		}
+	}
+	return STATE_SAME;
+}
+
+//!b Drives forwards before left turn.
+uint8_t WallFollower::statePreTurnLeft() {
+	DriveSystem::drive(
+		targetHeading(),
+		DRIVE_VELOCITY_MAX);
+	if(timer.hasElapsed(PRE_TURN_TIME)) {
+		setDirectionLeft();
+		return STATE_TURN_LEFT;
+	}
+	return checkFrontWall();
+}
+
+//!b Makes a 90-degree left turn.
+uint8_t WallFollower::stateTurnLeft() {
+	if(DriveSystem::turn(targetHeading())) {
+		return STATE_POST_TURN;
+	}
+	return STATE_SAME;
+}
+
+//!b Drives forwards after a turn.
+uint8_t WallFollower::statePostTurn() {
+	DriveSystem::drive(
+		targetHeading(),
+		DRIVE_VELOCITY_MAX);
+	uint8_t next = STATE_SAME;
+	if(nearLeftWall()) {
+		driveVelocity = DRIVE_VELOCITY_MAX;
+		VelocityPlanner::reset(DRIVE_VELOCITY_MAX);
+		next = STATE_FORWARD;
+	}
+	uint8_t front = checkFrontWall();
+	return (front != STATE_SAME) ? front : next;
+}
+
+//!b Backs away from a cliff.
+uint8_t WallFollower::stateBackFromCliff() {
+	DriveSystem::drive(
+		targetHeading(),
+		-DRIVE_VELOCITY_MAX);
+	if(timer.hasElapsed(CLIFF_BACK_TIME)) {
+		setDirectionRight();
+		return STATE_TURN_RIGHT;
+	}
+	return STATE_SAME;
+}
+
+//!b Makes a 90-degree right turn.
+uint8_t WallFollower::stateTurnRight() {
+	if(DriveSystem::turn(targetHeading())) {
+		return STATE_POST_TURN;
+	}
+	return STATE_SAME;
+}
+
+//!b Follows a 90-degree arc around an outside corner.
+uint8_t WallFollower::stateArcLeft() {
+	if(followArc()) {
+		setDirectionLeft();
+		return STATE_POST_TURN;
+	}
+	return STATE_SAME;
+}
+
+//!b Follows a 90-degree arc in front of an inside corner.
+uint8_t WallFollower::stateArcRight() {
+	if(followArc()) {
+		setDirectionRight();
+		return STATE_POST_TURN;
+	}
+	return STATE_SAME;
+}
+
+//!b Turns right if approaching a front wall.
+//!d Arcs around the corner if the front wall leaves room for
+//!d the minimum arc radius, otherwise pivots in place once the
+//!d front wall is reached. Returns the new state or STATE_SAME.
+uint8_t WallFollower::checkFrontWall() {
+	float radius = Sonar::distF - WALL_DISTANCE;
+	if(nearFrontArc() && radius >= ARC_RADIUS_MIN) {
+		startArc(radius);
+		return STATE_ARC_RIGHT;
+	} else if(nearFrontWall()) {
+		setDirectionRight();
+		return STATE_TURN_RIGHT;
+	}
+	return STATE_SAME;
+}
+
+//!b Starts a constant-curvature turn from the current position.
+//!i Arc radius (m) (positive right, negative left)
+//!d The radius magnitude is limited to the arc radius range.
+void WallFollower::startArc(float radius) {
+	float r = constrain(fabs(radius), ARC_RADIUS_MIN, ARC_RADIUS_MAX);
+	arcRadius = (radius < 0) ? -r : r;
+	arcStart = Odometer::distance;
+	arcHeading = targetHeading();
+}
+
+//!b Drives along the current arc.
+//!d Heading is commanded from distance travelled along the arc.
+//!d Returns true once the robot has turned 90 degrees.
+bool WallFollower::followArc() {
+	float s = Odometer::distance - arcStart;
+	DriveSystem::drive(
+		arcHeading + s / arcRadius,
+		ARC_VELOCITY);
+	return s >= fabs(arcRadius) * HALF_PI;
+}
+
+//!b Adds the left wall distance to the wall heading fit.
+//!d Takes one sample per sonar cycle. The fit restarts if a cycle
+//!d was missed, which happens whenever FORWARD is left or the wall
+//!d is lost, so every fit covers one straight wall.
+void WallFollower::updateFit() {
+	if(Sonar::cycles == fitCycle) return;
+	bool contiguous = (uint16_t)(Sonar::cycles - fitCycle) == 1;
+	fitCycle = Sonar::cycles;
+	if(!contiguous || fitN == 0) {
+		fitN = 0;
+		fitStart = Odometer::distance;
+		fitS = fitD = fitH = 0;
+		fitSS = fitSD = fitDD = 0;
+	}
+
+	// Accumulate travel, wall distance, and heading offset
+	float s = Odometer::distance - fitStart;
+	float d = Sonar::distL;
+	float h = Odometer::heading - targetHeading();
+	h = atan2(sin(h), cos(h));
+	fitS += s;
+	fitD += d;
+	fitH += h;
+	fitSS += s * s;
+	fitSD += s * d;
+	fitDD += d * d;
+	fitN++;
+
+	if(s >= FIT_LENGTH && fitN >= FIT_MIN_SAMPLES) {
+		applyFit();
+		fitN = 0;
+	}
+}
+
+//!b Corrects odometer heading from the completed wall fit.
+//!d A wall distance slope of k per metre travelled means the robot
+//!d is heading asin(k) away from the wall. Fits to walls that are
+//!d not straight or give implausible errors are ignored.
+void WallFollower::applyFit() {
+	float n = fitN;
+	float sss = fitSS - fitS * fitS / n;
+	float ssd = fitSD - fitS * fitD / n;
+	float sdd = fitDD - fitD * fitD / n;
+	if(sss <= 0) return;
+	float slope = ssd / sss;
+	float sse = sdd - slope * ssd;
+	if(sse > n * FIT_MAX_RMS * FIT_MAX_RMS || fabs(slope) >= 1) {
+		return;
+	}
+	float error = fitH / n - asin(slope);
+	if(fabs(error) <= FIT_MAX_ERROR) {
+		Odometer::correctHeading(FIT_GAIN * error);
+	}
+}
+
+//!b Sets gains of a wall-following controller at runtime.
+//!i Controller (see gains_t)
+//!i Proportional gain
+//!i Integral gain
+//!i Derivative gain
+//!d Returns false if the controller is not a wall-follower one.
+bool WallFollower::setGains(uint8_t pid, float kp, float ki, float kd) {
+	switch(pid) {
+		case GAINS_LEFT_WALL:
+			leftWallPid.setGains(kp, ki, kd);
+			return true;
+		case GAINS_FRONT_WALL:
+			frontWallPid.setGains(kp, ki, kd);
+			return true;
+		default:
+			return false;
 	}
 }
 
 //!b Returns byte indicating current state.
 //!d See state enumeration above for mapping details.
 byte WallFollower::getState() {
-	return (byte)state;
+	return machine.get();
+}
+
+//!b Returns state to return to when started.
+uint8_t WallFollower::getPausedState() {
+	return pausedState;
+}
+
+//!b Returns wall-following direction (for checkpoints).
+uint8_t WallFollower::getDirection() {
+	return direction;
 }
 
 //!b Returns true if wall follower can be paused without issues.
 bool WallFollower::inPausableState() {
+	uint8_t state = machine.get();
 	return
 		state == STATE_FORWARD ||
 		state == STATE_POST_TURN;
 }
 
+//!b Returns true if wall follower is stopped.
+bool WallFollower::isStopped() {
+	return machine.get() == STATE_STOPPED;
+}
+
+//!b Returns number of state numbers (including unused state 0).
+uint8_t WallFollower::numStates() {
+	return NUM_STATES;
+}
+
+//!b Clears wall-following state timing.
+void WallFollower::clearTiming() {
+	machine.clearTiming();
+}
+
+//!b Returns cumulative time (s) spent in given state.
+float WallFollower::dwellTime(uint8_t state) {
+	return machine.dwellTime(state);
+}
+
+//!b Returns number of times given state was entered.
+uint16_t WallFollower::entries(uint8_t state) {
+	return machine.entries(state);
+}
+
 //!b Returns heading (rad) based on wall-following direction.
 float WallFollower::targetHeading() {
 	switch(direction) {
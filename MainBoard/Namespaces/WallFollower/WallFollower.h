@@ -18,12 +18,29 @@
 //**************************************************************/
 
 namespace WallFollower {
+	enum gains_t {
+		GAINS_LEFT_WALL = 4,
+		GAINS_FRONT_WALL = 5,
+	};
+
 	void setup();
 	void start();
+	void restart();
 	void stop();
 	void loop();
+	void resume(uint8_t, uint8_t, uint8_t);
 
 	byte getState();
+	uint8_t getPausedState();
+	uint8_t getDirection();
 	bool inPausableState();
+	bool isStopped();
+	bool nearCliff();
 	float targetHeading();
+	bool setGains(uint8_t, float, float, float);
+
+	uint8_t numStates();
+	void clearTiming();
+	float dwellTime(uint8_t);
+	uint16_t entries(uint8_t);
 }
@@ -0,0 +1,275 @@
+function results = GainTuner(varargin)
+%GAINTUNER Tunes robot PID gains against a simulated drive plant.
+%   Created by Dan Oates (RBE-2002 B17 Team 10).
+%
+%   results = GAINTUNER() searches the gains of each robot controller
+%   for the lowest cost on a simulated step response. The loops mimic
+%   the firmware: FixedPid (Q12 errors, Q16 gains, derivative filter
+%   of gain 1/4, back-calculation anti-windup that only bleeds the integrator),
+%   the DriveSystem wheel feedforward and heading loop, and the
+%   WallFollower left and front wall loops with sample-and-hold sonar.
+%   The plant is a first-order wheel velocity model with friction on a
+%   differential drive base.
+%
+%   Each controller is searched with Nelder-Mead (fminsearch) from
+%   several random starts around the firmware gains. The starts run in
+%   parallel with parfor when the Parallel Computing Toolbox is
+%   available. The cost is the settling time (a mission time proxy)
+%   plus the weighted integral of absolute tracking error, with a
+%   penalty for front wall overshoot. Sonar noise and the random
+%   starts are seeded, so a tuning run is repeatable.
+%
+%   Name-value options:
+%   'Controllers' = controller ids to tune (default 1:5): 1 wheel
+%                   velocity, 2 heading pivot, 3 heading tracking,
+%                   4 left wall, 5 front wall (as RobotComms.setGains)
+%   'Starts'      = random starts per controller (default 8)
+%   'Plant'       = struct overriding fields of the plant model
+%   'Seed'        = seed of the random starts (default 1)
+%   'Comms'       = connected RobotComms to send the best gains to
+%
+%   results is a struct array with fields pid, gains ([kp ki kd]),
+%   cost, settle (s), overshoot, and iae, also printed as a table.
+%
+%   See also: ROBOTCOMMS
+
+    p = inputParser;
+    p.addParameter('Controllers', 1:5);
+    p.addParameter('Starts', 8);
+    p.addParameter('Plant', struct());
+    p.addParameter('Seed', 1);
+    p.addParameter('Comms', []);
+    p.parse(varargin{:});
+    opts = p.Results;
+
+    % Plant model (identify from a logged step for a new robot)
+    P.dt = 0.005;           % Loop period (s)
+    P.tau = 0.08;           % Wheel velocity time constant (s)
+    P.kv = 20.0;            % Motor V*s/m (matches WHEEL_KV)
+    P.ks = 1.0;             % Friction voltage (V) (matches WHEEL_KS)
+    P.deadband = 0.005;     % Feedforward deadband (m/s) (WHEEL_DEADBAND)
+    P.track = 0.23;         % Wheel track width (m)
+    P.sonarPeriod = 0.1;    % Sonar update period (s)
+    P.sonarNoise = 0.003;   % Sonar noise std (m)
+    P.horizon = 3.0;        % Simulated time (s)
+    names = fieldnames(opts.Plant);
+    for i = 1:length(names)
+        P.(names{i}) = opts.Plant.(names{i});
+    end
+
+    % Firmware gains [kp ki kd] by controller id
+    base = [
+        10.0, 40.0,  0.0;   % Wheel velocity
+        2.0,  0.005, 0.25;  % Heading pivot
+        1.2,  0.02,  0.08;  % Heading tracking
+        3.5,  0.0,   0.0;   % Left wall
+        1.5,  0.0,   0.0];  % Front wall
+
+    titles = {'Wheel velocity', 'Heading pivot', 'Heading tracking', ...
+        'Left wall', 'Front wall'};
+    results = struct('pid', {}, 'gains', {}, 'cost', {}, ...
+        'settle', {}, 'overshoot', {}, 'iae', {});
+
+    for pid = opts.Controllers
+        scale = max(base(pid, :), [1, 1, 0.1] .* base(pid, 1));
+        x0 = base(pid, :) ./ scale;
+        stream = RandStream('mt19937ar', 'Seed', opts.Seed + pid);
+        starts = [x0; x0 .* exp(0.7 * randn(stream, opts.Starts - 1, 3))];
+        best = zeros(opts.Starts, 3);
+        costs = zeros(opts.Starts, 1);
+        cost = @(x) tuneCost(pid, max(x, 0) .* scale, base, P);
+        parfor s = 1:opts.Starts
+            [x, c] = fminsearch(cost, starts(s, :), ...
+                optimset('MaxFunEvals', 300, 'Display', 'off'));
+            best(s, :) = max(x, 0) .* scale;
+            costs(s) = c;
+        end
+        [c, s] = min(costs);
+        [~, m] = tuneCost(pid, best(s, :), base, P);
+        r.pid = pid;
+        r.gains = best(s, :);
+        r.cost = c;
+        r.settle = m.settle;
+        r.overshoot = m.overshoot;
+        r.iae = m.iae;
+        results(end+1) = r; %#ok<AGROW>
+        [c0, m0] = tuneCost(pid, base(pid, :), base, P);
+        fprintf('%-17s kp %8.4f  ki %8.4f  kd %8.4f\n', ...
+            titles{pid}, r.gains);
+        fprintf('%17s cost %.3f (was %.3f)  settle %.2f s (was %.2f)\n', ...
+            '', c, c0, m.settle, m0.settle);
+        if ~isempty(opts.Comms)
+            [ok, msg] = opts.Comms.setGains(pid, r.gains(1), ...
+                r.gains(2), r.gains(3));
+            if ~ok
+                fprintf('%17s not sent: %s\n', '', msg);
+            end
+        end
+    end
+end
+
+function [J, m] = tuneCost(pid, g, base, P)
+%TUNECOST Cost and response metrics of one controller's gains.
+    G = base;
+    G(pid, :) = g;
+    [t, e, band, stopped] = simulate(pid, G, P);
+    outside = find(abs(e) > band, 1, 'last');
+    if isempty(outside)
+        m.settle = 0;
+    elseif outside == length(e)
+        m.settle = t(end) + abs(e(end));
+    else
+        m.settle = t(outside + 1);
+    end
+    m.overshoot = max(0, -min(e .* sign(e(1))));
+    m.iae = sum(abs(e)) * P.dt;
+    J = m.settle + 5 * m.iae + 20 * m.overshoot;
+    if stopped
+        J = J + 10;     % Hit the front wall
+    end
+end
+
+function [t, e, band, stopped] = simulate(pid, G, P)
+%SIMULATE Step response of one controller on the plant model.
+    n = round(P.horizon / P.dt);
+    t = (0:n-1)' * P.dt;
+    e = zeros(n, 1);
+    stopped = false;
+    noise = P.sonarNoise * randn(RandStream('mt19937ar', 'Seed', 1), n, 2);
+    WALL = 0.23;
+    CRUISE = 0.35;
+
+    % Controllers as in DriveSystem and WallFollower
+    wheelL = pidNew(G(1, :), -9, 9);
+    wheelR = pidNew(G(1, :), -9, 9);
+    if pid == 2
+        heading = pidNew(G(2, :), -0.15, 0.15);
+    else
+        heading = pidNew(G(3, :), -0.15, 0.15);
+    end
+    leftWall = pidNew(G(4, :), -0.2, 0.2);
+    frontWall = pidNew(G(5, :), 0, CRUISE);
+
+    % Plant state
+    vL = 0; vR = 0; h = 0;
+    distL = WALL + 0.1;
+    distF = 1.0;
+    sonarL = distL; sonarF = distF;
+    sonarNext = 0;
+    switch pid
+        case 1, band = 0.01;
+        case {2, 3}, band = 0.02;
+        case 4, band = 0.01;
+        case 5, band = 0.01;
+    end
+
+    for k = 1:n
+        if t(k) >= sonarNext
+            sonarL = distL + noise(k, 1);
+            sonarF = distF + noise(k, 2);
+            sonarNext = sonarNext + P.sonarPeriod;
+        end
+        switch pid
+            case 1      % Wheel velocity step
+                vt = 0.2; ht = 0;
+                e(k) = vt - vL;
+            case 2      % Pivot turn
+                vt = 0; ht = pi / 2;
+                e(k) = ht - h;
+            case 3      % Heading correction at speed
+                vt = 0.2; ht = 0.2;
+                e(k) = ht - h;
+            case 4      % Left wall following
+                vt = CRUISE;
+                [off, leftWall] = pidUpdate(leftWall, WALL - sonarL, P.dt);
+                ht = off;
+                e(k) = distL - WALL;
+            case 5      % Front wall approach
+                [vt, frontWall] = pidUpdate( ...
+                    frontWall, sonarF - WALL, P.dt);
+                ht = 0;
+                e(k) = distF - WALL;
+        end
+
+        % DriveSystem::track and driveWheels
+        [vDiff, heading] = pidUpdate(heading, ht - h, P.dt);
+        if pid == 1
+            vDiff = 0;
+        end
+        [uL, wheelL] = pidUpdate(wheelL, vt + vDiff - vL, P.dt);
+        [uR, wheelR] = pidUpdate(wheelR, vt - vDiff - vR, P.dt);
+        uL = min(max(feedforward(vt + vDiff, P) + uL, -12), 12);
+        uR = min(max(feedforward(vt - vDiff, P) + uR, -12), 12);
+
+        % Wheel and base dynamics
+        vL = vL + P.dt / P.tau * (motor(uL, P) - vL);
+        vR = vR + P.dt / P.tau * (motor(uR, P) - vR);
+        v = (vL + vR) / 2;
+        h = h + P.dt * (vL - vR) / P.track;
+        distL = distL + P.dt * v * sin(h);
+        distF = distF - P.dt * v * cos(h);
+        if distF < WALL - 0.1
+            stopped = true;
+            e(k+1:end) = e(k);
+            return
+        end
+    end
+end
+
+function u = feedforward(v, P)
+%FEEDFORWARD Wheel feedforward voltage as in DriveSystem.
+    if abs(v) > P.deadband
+        u = P.kv * v + P.ks * sign(v);
+    else
+        u = P.kv * v;
+    end
+end
+
+function v = motor(u, P)
+%MOTOR Steady-state wheel velocity for a voltage with friction.
+    if abs(u) <= P.ks
+        v = 0;
+    else
+        v = (u - P.ks * sign(u)) / P.kv;
+    end
+end
+
+function c = pidNew(g, lo, hi)
+%PIDNEW FixedPid state with default tracking gain.
+    q = @(x) floor(x * 65536) / 65536;
+    c.kp = q(g(1)); c.ki = q(g(2)); c.kd = q(g(3));
+    if g(2) == 0 || g(1) == 0
+        c.kb = c.ki;
+    elseif g(3) == 0
+        c.kb = q(g(2) / g(1));
+    else
+        c.kb = q(sqrt(g(2) / g(3)));
+    end
+    c.lo = lo; c.hi = hi; c.imax = max(abs(lo), abs(hi));
+    c.integral = 0; c.derivative = 0; c.last = NaN;
+end
+
+function [u, c] = pidUpdate(c, e, dt)
+%PIDUPDATE One FixedPid update.
+    sat16 = @(x) min(max(x, -32767 / 4096), 32767 / 4096);
+    e = sat16(floor(e * 4096) / 4096);
+    if isnan(c.last)
+        c.last = e;
+    end
+    raw = sat16((e - c.last) / dt);
+    c.derivative = c.derivative + (raw - c.derivative) / 4;
+    c.last = e;
+    c.integral = min(max(c.integral + c.ki * e * dt, -c.imax), c.imax);
+    u = c.kp * e + c.integral + c.kd * c.derivative;
+    uSat = min(max(u, c.lo), c.hi);
+    back = c.kb * (uSat - u) * dt;
+    if sign(back) == -sign(c.integral) && back ~= 0
+        bled = c.integral + back;
+        if sign(bled) == sign(c.integral)
+            c.integral = bled;
+        else
+            c.integral = 0;
+        end
+    end
+    u = uSat;
+end
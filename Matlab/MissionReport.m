@@ -0,0 +1,86 @@
+function summary = MissionReport(files, outFile)
+%MISSIONREPORT Summarizes logged mission statistics per firmware revision.
+%   Created by Dan Oates (RBE-2002 B17 Team 10).
+%
+%   summary = MISSIONREPORT(files) reads one or more mission logs written
+%   by RobotConsole or Host/FireBotSim (MissionLog.csv format), one per
+%   firmware revision, and returns a table with one row per log. A single
+%   file name may be given as a string. Simulated runs that hit the time
+%   limit have fault code -1, so count as neither home nor a fault. Each
+%   row holds the number of runs, the success rate (runs that reached
+%   home), the number of checkpoint resumes, counts of each failure mode
+%   (fault code of runs that did not reach home), and the median, 10th
+%   and 90th percentile, mean, and standard deviation of time to flame,
+%   time to extinguish, time to home, and home error over the runs that
+%   reached each milestone. Histograms of each metric are plotted with
+%   one series per log.
+%
+%   MISSIONREPORT(files, outFile) also writes the table to a CSV file, so
+%   the statistics of two firmware revisions can be diffed.
+%
+%   See also: ROBOTCONSOLE
+
+    if ischar(files)
+        files = {files};
+    end
+    metrics = {'timeToFlame', 'timeToExtinguish', 'timeToHome', ...
+        'homeError'};
+    stats = {'Median', 'P10', 'P90', 'Mean', 'Std'};
+    faults = 0:3;
+
+    summary = table();
+    figure
+    for f = 1:length(files)
+        data = readtable(files{f});
+        [~, name] = fileparts(files{f});
+        row = table({name}, height(data), 'VariableNames', {'log', 'runs'});
+
+        % Success and failure modes
+        home = data.timeToHome >= 0;
+        row.successRate = mean(home);
+        row.resumes = sum(data.resumes);
+        for c = faults
+            row.(sprintf('fault%d', c)) = sum(~home & data.faultCode == c);
+        end
+
+        % Milestone distributions
+        for m = 1:length(metrics)
+            x = data.(metrics{m});
+            if strcmp(metrics{m}, 'homeError')
+                x = x(home);
+            else
+                x = x(x >= 0);  % Milestone reached
+            end
+            v = [pct(x, 50), pct(x, 10), pct(x, 90), mean(x), std(x)];
+            for s = 1:length(stats)
+                row.([metrics{m} stats{s}]) = v(s);
+            end
+            subplot(2, 2, m)
+            hold on
+            histogram(x, 'DisplayName', name)
+            title(metrics{m})
+        end
+        summary = [summary; row]; %#ok<AGROW>
+    end
+    for m = 1:length(metrics)
+        subplot(2, 2, m)
+        legend('Interpreter', 'none')
+    end
+    disp(summary)
+    if nargin > 1
+        writetable(summary, outFile);
+    end
+end
+
+function y = pct(x, p)
+%PCT Linearly interpolated p-th percentile (NaN if x is empty).
+    x = sort(x(:));
+    n = length(x);
+    if n == 0
+        y = NaN;
+    elseif n == 1
+        y = x;
+    else
+        y = interp1(0:n-1, x, (n - 1) * p / 100);
+    end
+end
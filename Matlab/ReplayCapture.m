@@ -0,0 +1,97 @@
+function loops = ReplayCapture(file, port)
+%REPLAYCAPTURE Replays a raw input capture into a replay build.
+%   Created by Dan Oates (RBE-2002 B17 Team 10).
+%
+%   loops = REPLAYCAPTURE(file) splits the capture saved by the SD
+%   serial logger into per-loop chunks of records and returns them as a
+%   cell array, one chunk of raw bytes per loop. The first chunk holds
+%   the inputs read during setup.
+%
+%   loops = REPLAYCAPTURE(file, port) also streams the chunks to a robot
+%   built with CAPTURE_ENABLED and CAPTURE_REPLAY set to 1, connected on
+%   its capture port (Serial2, 500000 baud). Before each loop the robot
+%   sends 'N' for the next chunk, which is answered with a uint16
+%   little-endian length and the records, or 'D' once its reads have
+%   diverged from the capture, which ends the replay. A length of 0 is
+%   sent once the capture is exhausted. Record formats match Capture.h
+%   in the robot firmware.
+%
+%   See also: TRACEVIEW
+
+    SYNC = [hex2dec('A5'), hex2dec('5A')];
+    RECORD_LOOP = 1;
+    CHUNK_MAX = 256;
+
+    % Payload sizes by record type (bytes)
+    payload = [8, 4, 8, 5, 3, 1, 1, 4, 6];
+
+    % Read capture
+    fid = fopen(file, 'r');
+    if fid < 0
+        error('Could not open capture file %s.', file);
+    end
+    raw = fread(fid, inf, 'uint8=>uint8')';
+    fclose(fid);
+
+    % Split into loops
+    loops = {};
+    p = 1;
+    start = 0;
+    last = 1;
+    while p <= length(raw)
+        if p + 2 <= length(raw) && ...
+                all(raw(p:p+1) == SYNC) && raw(p+2) == RECORD_LOOP
+            if start > 0
+                loops{end+1} = raw(start:p-1); %#ok<AGROW>
+            end
+            p = p + 2;
+            start = p;
+        elseif start == 0
+            p = p + 1;  % Skip to first sync
+            continue
+        end
+        last = p;
+        type = raw(p);
+        if type < 1 || type > length(payload)
+            error('Bad record type 0x%02X at byte %d.', type, p);
+        end
+        p = p + 1 + payload(type);
+    end
+    if start > 0
+        if p - 1 > length(raw)
+            p = last;   % Drop record cut off at end of capture
+        end
+        loops{end+1} = raw(start:p-1);
+    end
+    if any(cellfun(@length, loops) > CHUNK_MAX)
+        error('Capture has loops over %d bytes.', CHUNK_MAX);
+    end
+    fprintf('%d loops in capture.\n', length(loops));
+    if nargin < 2
+        return
+    end
+
+    % Stream loops to robot
+    s = serial(port, 'BaudRate', 500000, 'Timeout', 5);
+    fopen(s);
+    cleanup = onCleanup(@() fclose(s));
+    tic
+    for i = 1:length(loops) + 1
+        request = fread(s, 1, 'uint8');
+        if isempty(request)
+            error('Robot stopped requesting loops at loop %d.', i - 1);
+        end
+        if request == 'D'
+            fprintf('Replay diverged in loop %d.\n', i - 2);
+            return
+        end
+        if i > length(loops)
+            fwrite(s, [0, 0], 'uint8');
+        else
+            n = length(loops{i});
+            fwrite(s, [mod(n, 256), floor(n / 256), loops{i}], 'uint8');
+        end
+    end
+    fprintf('Replayed %d loops in %.1f s without divergence.\n', ...
+        length(loops), toc);
+end
@@ -17,6 +17,13 @@ classdef RobotComms < handle
         BYTE_CONNECT    = hex2dec('01');    % Connect & start robot
         BYTE_GETDATA    = hex2dec('02');    % Robot data requests
         BYTE_DISCONNECT = hex2dec('03');    % Disconnect
+        BYTE_SETGAINS   = hex2dec('04');    % Set controller gains
+        BYTE_GETMISSION = hex2dec('05');    % Mission statistics
+        BYTE_GETTIMING  = hex2dec('06');    % State timing profile
+        BYTE_GETTRACE   = hex2dec('07');    % Event trace dump
+        BYTE_GETMEMORY  = hex2dec('08');    % SRAM usage
+        BYTE_GETFAULT   = hex2dec('09');    % Fault snapshot
+        BYTE_CLEARFAULT = hex2dec('0A');    % Clear fault and resume
     end
     
     properties (Access = private)
@@ -92,7 +99,7 @@ classdef RobotComms < handle
             obj.serial.writeByte(obj.BYTE_GETDATA);
             
             % Wait for data to return
-            if obj.serial.wait(31, obj.TIMEOUT)
+            if obj.serial.wait(39, obj.TIMEOUT)
                 if obj.serial.readByte() ~= obj.BYTE_GETDATA
                     rd = 0;
                     error = 'Data response incorrect';
@@ -111,27 +118,31 @@ classdef RobotComms < handle
             stateByte = obj.serial.readByte();
             switch stateByte
                 case  1, robotState = 'Searching for flame';
-                case  2, robotState = 'Zeroing pan servo';
-                case  3, robotState = 'Finding flame heading';
-                case  4, robotState = 'Turning to flame heading';
-                case  5, robotState = 'Driving to candle';
-                case  6, robotState = 'Lowering tilt servo';
-                case  7, robotState = 'Finding flame tilt';
-                case  8, robotState = 'Aiming at flame';
-                case  9, robotState = 'Extinguishing flame';
-                case 10, robotState = 'Checking if flame is out';
-                case 11, robotState = 'Backing away from candle';
-                case 12, robotState = 'Turning back to wall';
-                case 13, robotState = 'Going home';
-                case 14, robotState = 'At home';
+                case  2, robotState = 'Confirming flame';
+                case  3, robotState = 'Zeroing pan servo';
+                case  4, robotState = 'Finding flame heading';
+                case  5, robotState = 'Turning to flame heading';
+                case  6, robotState = 'Driving to candle';
+                case  7, robotState = 'Lowering tilt servo';
+                case  8, robotState = 'Finding flame tilt';
+                case  9, robotState = 'Aiming at flame';
+                case 10, robotState = 'Extinguishing flame';
+                case 11, robotState = 'Checking if flame is out';
+                case 12, robotState = 'Backing away from candle';
+                case 13, robotState = 'Turning back to wall';
+                case 14, robotState = 'Going home';
+                case 15, robotState = 'At home';
+                case 16, robotState = 'Fault';
                 otherwise, robotState = 'INVALID STATE';
             end
             
             % Deduce Flame Status
-            if stateByte == 1
+            if stateByte == 1 || stateByte == 2
                 flameStatus = 'Not Found';
-            elseif stateByte >= 2
-                if stateByte >= 12
+            elseif stateByte == 16
+                flameStatus = 'Unknown (fault)';
+            elseif stateByte >= 3
+                if stateByte >= 13
                     flameStatus = 'Extinguished';
                 else
                     flameStatus = 'Found';
@@ -148,6 +159,8 @@ classdef RobotComms < handle
                 case 6, wallFollowerState = 'Post turn';
                 case 7, wallFollowerState = 'Backing from cliff';
                 case 8, wallFollowerState = 'Turning right';
+                case 9, wallFollowerState = 'Arc turning left';
+                case 10, wallFollowerState = 'Arc turning right';
                 otherwise, wallFollowerState = 'INVALID STATE';
             end
             
@@ -163,9 +176,300 @@ classdef RobotComms < handle
                 obj.serial.readFloat(); ...
                 obj.serial.readFloat(); ...
                 obj.serial.readFloat()];
+            battery = obj.serial.readFloat();
+            cycle = 0;
+            for k = 0:3
+                cycle = cycle + obj.serial.readByte() * 256^k;
+            end
             
             rd = RobotData(x, y, h, sF, sB, sL, sR, flamePos, ...
                 robotState, wallFollowerState, flameStatus);
+            rd.battery = battery;
+            rd.cycle = cycle;
+        end
+        function [m, s, error] = getMission(obj)
+            % Requests mission statistics from robot.
+            %   m = struct of mission statistics (times in s from start,
+            %       -1 if milestone not reached, boot or resume time in
+            %       s from reset, number of checkpoint resumes)
+            %   s = data response status (1 for ok, 0 for failure)
+            %   error = '' or error message string relating to failure
+            
+            m = struct();
+            s = 0;
+            error = '';
+            
+            % Request mission statistics from robot
+            obj.serial.writeByte(obj.BYTE_GETMISSION);
+            
+            % Wait for data to return
+            if obj.serial.wait(36, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_GETMISSION
+                    error = 'Mission response incorrect';
+                    return
+                end
+            else
+                error = 'Mission response timeout';
+                return
+            end
+            
+            % Read statistics
+            m.state = obj.serial.readByte();
+            m.faultCode = obj.serial.readByte();
+            m.timeToFlame = obj.serial.readFloat();
+            m.timeToExtinguish = obj.serial.readFloat();
+            m.timeToHome = obj.serial.readFloat();
+            m.homeError = obj.serial.readFloat();
+            m.flamePos = [...
+                obj.serial.readFloat(); ...
+                obj.serial.readFloat(); ...
+                obj.serial.readFloat()];
+            m.bootTime = obj.serial.readFloat();
+            m.resumes = obj.serial.readByte();
+            s = 1;
+        end
+        function [t, s, error] = getTiming(obj)
+            % Requests state timing profile from robot.
+            %   t = struct with fields fireBot and wallFollower, each an
+            %       n-by-2 matrix of [dwell time (s), entry count] rows
+            %       indexed by state number
+            %   s = data response status (1 for ok, 0 for failure)
+            %   error = '' or error message string relating to failure
+            
+            t = struct();
+            s = 0;
+            error = '';
+            
+            % Request state timing from robot
+            obj.serial.writeByte(obj.BYTE_GETTIMING);
+            
+            % Wait for header
+            if obj.serial.wait(2, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_GETTIMING
+                    error = 'Timing response incorrect';
+                    return
+                end
+            else
+                error = 'Timing response timeout';
+                return
+            end
+            
+            % Read FireBot then WallFollower state tables
+            [t.fireBot, ok] = obj.readTiming();
+            if ok && obj.serial.wait(1, obj.TIMEOUT)
+                [t.wallFollower, ok] = obj.readTiming();
+            else
+                ok = 0;
+            end
+            if ~ok
+                error = 'Timing response timeout';
+                return
+            end
+            s = 1;
+        end
+        function [tr, s, error] = getTrace(obj)
+            % Dumps and clears the robot event trace buffer.
+            %   tr = struct of column vectors time (s), event, and
+            %        payload (see TRACEVIEW), plus the measured event
+            %        costs loopCycles and isrCycles (CPU cycles) and
+            %        the count of ISR records dropped since boot
+            %   s = data response status (1 for ok, 0 for failure)
+            %   error = '' or error message string relating to failure
+            
+            tr = struct('time', [], 'event', [], 'payload', [], ...
+                'loopCycles', 0, 'isrCycles', 0, 'dropped', 0);
+            s = 0;
+            error = '';
+            
+            % Request event trace from robot
+            obj.serial.writeByte(obj.BYTE_GETTRACE);
+            
+            % Wait for header
+            if obj.serial.wait(2, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_GETTRACE
+                    error = 'Trace response incorrect';
+                    return
+                end
+            else
+                error = 'Trace response timeout';
+                return
+            end
+            
+            % Read counts and writer costs
+            if ~obj.serial.wait(6, obj.TIMEOUT)
+                error = 'Trace response timeout';
+                return
+            end
+            n = obj.serial.readByte();
+            tr.loopCycles = obj.serial.readByte() + ...
+                256 * obj.serial.readByte();
+            tr.isrCycles = obj.serial.readByte() + ...
+                256 * obj.serial.readByte();
+            tr.dropped = obj.serial.readByte();
+            
+            % Read records (7 bytes each, little-endian)
+            if ~obj.serial.wait(7 * n, obj.TIMEOUT)
+                error = 'Trace response timeout';
+                return
+            end
+            tr.time = zeros(n, 1);
+            tr.event = zeros(n, 1);
+            tr.payload = zeros(n, 1);
+            for i = 1:n
+                t = 0;
+                for k = 0:3
+                    t = t + obj.serial.readByte() * 256^k;
+                end
+                tr.time(i) = t * 1e-6;
+                tr.event(i) = obj.serial.readByte();
+                tr.payload(i) = obj.serial.readByte() + ...
+                    256 * obj.serial.readByte();
+            end
+            s = 1;
+        end
+        function [mem, s, error] = getMemory(obj)
+            % Requests SRAM usage from robot.
+            %   mem = struct of byte counts: static (data and bss),
+            %         heap, stack (high-water mark), and margin (never
+            %         touched between heap and stack)
+            %   s = data response status (1 for ok, 0 for failure)
+            %   error = '' or error message string relating to failure
+            
+            mem = struct();
+            s = 0;
+            error = '';
+            
+            % Request memory usage from robot
+            obj.serial.writeByte(obj.BYTE_GETMEMORY);
+            
+            % Wait for data to return
+            if obj.serial.wait(17, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_GETMEMORY
+                    error = 'Memory response incorrect';
+                    return
+                end
+            else
+                error = 'Memory response timeout';
+                return
+            end
+            
+            % Read usage
+            mem.static = obj.serial.readFloat();
+            mem.heap = obj.serial.readFloat();
+            mem.stack = obj.serial.readFloat();
+            mem.margin = obj.serial.readFloat();
+            s = 1;
+        end
+        function [f, s, error] = getFault(obj)
+            % Requests fault snapshot from robot.
+            %   f = struct with fault code (-1 if not in fault mode),
+            %       robot and wall-follower state bytes at the fault,
+            %       mission time (s), position [x; y] (m), heading
+            %       (rad), sonar distances [F; B; L; R] (m), and
+            %       battery voltage (V)
+            %   s = data response status (1 for ok, 0 for failure)
+            %   error = '' or error message string relating to failure
+            
+            f = struct();
+            s = 0;
+            error = '';
+            
+            % Request fault snapshot from robot
+            obj.serial.writeByte(obj.BYTE_GETFAULT);
+            
+            % Wait for data to return
+            if obj.serial.wait(40, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_GETFAULT
+                    error = 'Fault response incorrect';
+                    return
+                end
+            else
+                error = 'Fault response timeout';
+                return
+            end
+            
+            % Read snapshot
+            f.code = obj.serial.readByte();
+            if f.code == 255
+                f.code = -1;
+            end
+            f.state = obj.serial.readByte();
+            f.wallState = obj.serial.readByte();
+            f.time = obj.serial.readFloat();
+            f.position = [obj.serial.readFloat(); obj.serial.readFloat()];
+            f.heading = obj.serial.readFloat();
+            f.sonar = zeros(4, 1);
+            for i = 1:4
+                f.sonar(i) = obj.serial.readFloat();
+            end
+            f.battery = obj.serial.readFloat();
+            s = 1;
+        end
+        function [s, error] = clearFault(obj)
+            % Clears robot fault and resumes the state it faulted in.
+            %   s = acknowledge status (1 for success, 0 for failure)
+            %   error = '' or error message string if clear failed
+            
+            s = 0;
+            error = '';
+            
+            % Send clear command to robot
+            obj.serial.writeByte(obj.BYTE_CLEARFAULT);
+            
+            % Wait for acknowledge
+            if obj.serial.wait(2, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_CLEARFAULT
+                    error = 'Clear fault response incorrect';
+                    return
+                end
+                if obj.serial.readByte() ~= 1
+                    error = 'Robot not in fault mode';
+                    return
+                end
+            else
+                error = 'Clear fault response timeout';
+                return
+            end
+            
+            % If all went well
+            s = 1;
+        end
+        function [s, error] = setGains(obj, pid, kp, ki, kd)
+            % Sets PID gains of a robot controller while it runs.
+            % Inputs:
+            %   pid = controller (1 wheel velocity, 2 heading pivot,
+            %         3 heading tracking, 4 left wall, 5 front wall)
+            %   kp, ki, kd = PID gains
+            %   s = acknowledge status (1 for success, 0 for failure)
+            %   error = '' or error message string if update failed
+            
+            s = 0;
+            error = '';
+            
+            % Send gains to robot
+            obj.serial.writeByte(obj.BYTE_SETGAINS);
+            obj.serial.writeByte(pid);
+            obj.serial.writeFloat(kp);
+            obj.serial.writeFloat(ki);
+            obj.serial.writeFloat(kd);
+            
+            % Wait for acknowledge
+            if obj.serial.wait(2, obj.TIMEOUT)
+                if obj.serial.readByte() ~= obj.BYTE_SETGAINS
+                    error = 'Gains response incorrect';
+                    return
+                end
+                if obj.serial.readByte() ~= 1
+                    error = 'Invalid controller';
+                    return
+                end
+            else
+                error = 'Gains response timeout';
+                return
+            end
+            
+            % If all went well
+            s = 1;
         end
         function disconnect(obj)
             % Sends stop message to robot then disconnects from Bluetooth.
@@ -181,4 +485,24 @@ classdef RobotComms < handle
             obj.disconnect();
         end
     end
+    
+    methods (Access = private)
+        function [timing, ok] = readTiming(obj)
+            % Reads one state machine timing table from robot.
+            %   timing = n-by-2 matrix of [dwell time (s), entries]
+            %   ok = 1 if the table arrived, 0 on timeout
+            
+            n = obj.serial.readByte();
+            timing = zeros(n, 2);
+            ok = obj.serial.wait(6 * n, obj.TIMEOUT);
+            if ~ok
+                return
+            end
+            for i = 1:n
+                timing(i, 1) = obj.serial.readFloat();
+                timing(i, 2) = 256 * obj.serial.readByte() + ...
+                    obj.serial.readByte();
+            end
+        end
+    end
 end
\ No newline at end of file
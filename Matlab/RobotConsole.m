@@ -5,7 +5,7 @@
 %   and field mapping. It can also 'replay' the previous field run from the
 %   file 'RobotLog.mat'.
 %
-%   See also: ROBOTDATA, ROBOTUI, ROBOTCOMMS, MAPBUILDER
+%   See also: ROBOTDATA, ROBOTUI, ROBOTCOMMS, MAPBUILDER, TRACEVIEW
 
 %% Initialization
 % Clear workspace
@@ -18,6 +18,7 @@ ui = RobotUI();
 robot = RobotComms('Arduino', 1);
 map = MapBuilder();
 logName = 'RobotLog.mat';
+missionLogName = 'MissionLog.csv';
 
 %% First User Input
 % Options:
@@ -101,6 +102,9 @@ end
 %% Robot Loop (Autonomous or Replay)
 % Initialization
 loop = 1;
+missionLogged = 0;
+dataFailures = 0;
+maxDataFailures = 5;    % Allows robot to resume after a reset
 if ~replay
     % Create empty array of robot data for log
     maxLoops = 10000;
@@ -125,12 +129,67 @@ while 1
         [rd, s, error] = robot.getData();
         if s == 0
             disp(error)
+            dataFailures = dataFailures + 1;
+            if dataFailures < maxDataFailures
+                continue
+            end
             robot.disconnect();
             break
         end
+        dataFailures = 0;
+        
+        % Check frame sequence (repeat or robot reset)
+        if loop > 1
+            lastCycle = robotLog(loop - 1).cycle;
+            if rd.cycle == lastCycle
+                disp('Warning: repeated telemetry frame')
+            elseif rd.cycle < lastCycle
+                disp('Warning: robot cycle count went back (reset?)')
+            else
+                disp(['Cycles since last frame: ' ...
+                    int2str(rd.cycle - lastCycle)])
+            end
+        end
         
         % Add robot data to log
         robotLog(loop) = rd;
+        
+        % Show fault snapshot (robot.clearFault() resumes)
+        if strcmp(rd.robotState, 'Fault')
+            [f, s] = robot.getFault();
+            if s == 1
+                fprintf(['FAULT %d in state %d (wall-follower %d) ' ...
+                    'at %.1f s, (%.2f, %.2f) m, %.1f V\n'], ...
+                    f.code, f.state, f.wallState, f.time, ...
+                    f.position(1), f.position(2), f.battery);
+            end
+        end
+        
+        % Log mission statistics once robot is home or faulted
+        if ~missionLogged && (strcmp(rd.robotState, 'At home') || ...
+                strcmp(rd.robotState, 'Fault'))
+            [m, s, error] = robot.getMission();
+            if s == 1
+                logMission(missionLogName, m);
+            else
+                disp(error)
+            end
+            [mem, s, error] = robot.getMemory();
+            if s == 1
+                fprintf(['SRAM: %d static, %d heap, %d stack, ' ...
+                    '%d margin (bytes)\n'], mem.static, mem.heap, ...
+                    mem.stack, mem.margin);
+            else
+                disp(error)
+            end
+            [tr, s, error] = robot.getTrace();
+            if s == 1
+                TraceView(tr);
+            else
+                disp(error)
+            end
+            missionLogged = 1;
+        end
     else
         % Replay Loop
         displayTitle('Replay Mode');
@@ -157,6 +216,7 @@ while 1
     disp(['y: ' num2str(rd.pos(2), '%+.2f') ' [m]'])
     disp(['h: ' num2str(rad2deg(rd.heading), '%.0f') ' [deg]'])
     disp(['Alignment: ' rd.getAlignment()])
+    disp(['Battery: ' num2str(rd.battery, '%.2f') ' [V]'])
     disp(' ')
     
     disp('FLAME')
@@ -221,6 +281,24 @@ function displayTitle(subtitle)
     disp('-------------------------------------------------')
 end
 
+function logMission(fileName, m)
+    % Appends mission statistics as a row of a CSV file
+    if ~isfile(fileName)
+        fid = fopen(fileName, 'w');
+        fprintf(fid, ['date,state,faultCode,timeToFlame,' ...
+            'timeToExtinguish,timeToHome,homeError,' ...
+            'flameX,flameY,flameZ,bootTime,resumes\n']);
+    else
+        fid = fopen(fileName, 'a');
+    end
+    fprintf(fid, '%s,%d,%d,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f,%.3f,%d\n', ...
+        datestr(now, 'yyyy-mm-dd HH:MM:SS'), m.state, m.faultCode, ...
+        m.timeToFlame, m.timeToExtinguish, m.timeToHome, ...
+        m.homeError, m.flamePos(1), m.flamePos(2), m.flamePos(3), ...
+        m.bootTime, m.resumes);
+    fclose(fid);
+end
+
 function plotFlame(pos)
     % Plots flame given position in [x; y; z] format
     x0 = pos(1) - 0.06;
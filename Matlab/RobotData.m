@@ -26,6 +26,8 @@ classdef RobotData < handle
         robotState = '';        % Robot state (string)
         wallFollowerState = ''; % Wall follower state (string)
         flameStatus = '';       % Flame status (string)
+        battery = 0;            % Battery voltage (V)
+        cycle = 0;              % Robot control cycle of data
     end
     properties (Access = private, Constant)
         RADIUS = 0.14;      % Approximate robot radius (m)
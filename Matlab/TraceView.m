@@ -0,0 +1,84 @@
+function TraceView(tr)
+%TRACEVIEW Plots a robot event trace dump as a timeline.
+%   Created by Dan Oates (RBE-2002 B17 Team 10).
+%   
+%   TRACEVIEW(tr) plots the struct returned by RobotComms.getTrace with
+%   one row per event type and prints each record decoded to the
+%   command window. Main loop and ISR records are merged by time. The
+%   measured cost per event and any dropped ISR records are printed
+%   first. Event ids and payload formats match Trace.h in the robot
+%   firmware.
+%
+%   See also: ROBOTCOMMS
+
+    names = {'FireBot state', 'WallFollower state', 'Sonar', ...
+        'Encoder L', 'Encoder R', 'PID saturated', 'Matlab message', ...
+        'Heading fix'};
+    sonars = {'F', 'B', 'L', 'R', 'Ping'};
+    pids = {'Wheel L', 'Wheel R', 'Heading', 'Left wall', 'Front wall'};
+    
+    fprintf('Event cost: %d cycles (loop), %d cycles (ISR)\n', ...
+        tr.loopCycles, tr.isrCycles);
+    if tr.dropped > 0
+        fprintf('ISR records dropped since boot: %d\n', tr.dropped);
+    end
+    if isempty(tr.time)
+        disp('Event trace is empty.')
+        return
+    end
+    
+    % Merge loop and ISR records
+    [~, order] = sort(tr.time);
+    tr.time = tr.time(order);
+    tr.event = tr.event(order);
+    tr.payload = tr.payload(order);
+    t = tr.time - tr.time(1);
+    
+    % Decode records
+    for i = 1:length(t)
+        e = tr.event(i);
+        p = tr.payload(i);
+        switch e
+            case {1, 2}
+                text = sprintf('%d -> %d', ...
+                    floor(p / 256), mod(p, 256));
+            case 3
+                text = sprintf('%s %.3f m', ...
+                    sonars{floor(p / 4096)}, mod(p, 4096) / 1000);
+            case {4, 5}
+                text = char('A' + p);
+            case 6
+                limit = 'low';
+                if p >= 256, limit = 'high'; end
+                text = sprintf('%s (%s)', pids{mod(p, 256)}, limit);
+            case 7
+                text = sprintf('0x%02X', p);
+            case 8
+                if p >= 32768, p = p - 65536; end
+                text = sprintf('%+d mrad', p);
+            otherwise
+                text = sprintf('%d', p);
+        end
+        if e >= 1 && e <= length(names)
+            name = names{e};
+        else
+            name = sprintf('Event %d', e);
+        end
+        fprintf('%9.4f s  %-18s %s\n', t(i), name, text);
+    end
+    
+    % Plot timeline
+    figure
+    hold on
+    for e = 1:length(names)
+        k = (tr.event == e);
+        plot(t(k), e * ones(sum(k), 1), '|', 'MarkerSize', 12)
+    end
+    hold off
+    yticks(1:length(names))
+    yticklabels(names)
+    ylim([0.5, length(names) + 0.5])
+    xlabel('Time (s)')
+    title('Robot Event Trace')
+    grid on
+end